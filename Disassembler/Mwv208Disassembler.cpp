@@ -11,14 +11,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "Mwv208Disassembler.h"
+#include "MCTargetDesc/Mwv208BaseInfo.h"
 #include "MCTargetDesc/Mwv208MCTargetDesc.h"
 #include "TargetInfo/Mwv208TargetInfo.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCDecoderOps.h"
-#include "llvm/MC/MCDisassembler/MCDisassembler.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MathExtras.h"
 
 using namespace llvm;
 
@@ -26,21 +30,6 @@ using namespace llvm;
 
 typedef MCDisassembler::DecodeStatus DecodeStatus;
 
-namespace {
-
-/// A disassembler class for Mwv208.
-class Mwv208Disassembler : public MCDisassembler {
-public:
-  Mwv208Disassembler(const MCSubtargetInfo &STI, MCContext &Ctx)
-      : MCDisassembler(STI, Ctx) {}
-  virtual ~Mwv208Disassembler() = default;
-
-  DecodeStatus getInstruction(MCInst &Instr, uint64_t &Size,
-                              ArrayRef<uint8_t> Bytes, uint64_t Address,
-                              raw_ostream &CStream) const override;
-};
-} // namespace
-
 static MCDisassembler *createMwv208Disassembler(const Target &T,
                                                 const MCSubtargetInfo &STI,
                                                 MCContext &Ctx) {
@@ -53,9 +42,236 @@ extern "C" LLVM_EXTERNAL_VISIBILITY void LLVMInitializeMwv208Disassembler() {
                                          createMwv208Disassembler);
 }
 
+static const MCRegisterClass &getRegClass(const MCDisassembler *Decoder,
+                                          unsigned RCID) {
+  return Decoder->getContext().getRegisterInfo()->getRegClass(RCID);
+}
+
+// Registers are numbered by their address inside each register class, see
+// the HWEncoding layout in Mwv208RegisterInfo.td.
+static DecodeStatus decodeRegAddr(MCInst &Inst, unsigned RCID, unsigned Addr,
+                                  const MCDisassembler *Decoder) {
+  const MCRegisterClass &RC = getRegClass(Decoder, RCID);
+  if (Addr >= RC.getNumRegs())
+    return MCDisassembler::Fail;
+  Inst.addOperand(MCOperand::createReg(RC.getRegister(Addr)));
+  return MCDisassembler::Success;
+}
+
+// Destination operands are encoded as {write enable[15:12], address[8:0]}.
+// A full mask names the whole register, a single-lane mask one of its
+// component registers. Other partial masks have no register to name.
+static DecodeStatus
+DecodeTempRegClassRegisterClass(MCInst &Inst, uint64_t RegNo,
+                                uint64_t Address,
+                                const MCDisassembler *Decoder) {
+  unsigned Addr = RegNo & 0x1ff;
+  if (MWV208::getWriteMask(RegNo) == 0xf)
+    return decodeRegAddr(Inst, MWV208::TempRegClassRegClassID, Addr, Decoder);
+
+  int Lane = MWV208::getComponentLane(RegNo);
+  if (Lane < 0)
+    return MCDisassembler::Fail;
+  // Component32 lists the components register by register, see
+  // Mwv208RegisterInfo.td.
+  return decodeRegAddr(Inst, MWV208::Component32RegClassID, Addr * 4 + Lane,
+                       Decoder);
+}
+
+// a0 is only named by mova, whose destination write mask picks the
+// component.
+static DecodeStatus DecodeAddrRegRegisterClass(MCInst &Inst, uint64_t RegNo,
+                                               uint64_t Address,
+                                               const MCDisassembler *Decoder) {
+  int Lane = MWV208::getComponentLane(RegNo);
+  if (Lane < 0 || (RegNo & 0x1ff) != 0)
+    return MCDisassembler::Fail;
+  return decodeRegAddr(Inst, MWV208::AddrRegRegClassID, Lane, Decoder);
+}
+
+// Source operands are encoded as
+// {REL_ADR[24:22], ABS[21], NEG[20], SWIZZLE[19:12], TYPE[11:9], ADR[8:0]}
+// and decode to the (reg, swizzle, mod) triple of Mwv208SrcOperand.
+static DecodeStatus decodeSrcOperand(MCInst &Inst, uint64_t Val,
+                                     uint64_t Address,
+                                     const MCDisassembler *Decoder) {
+  unsigned Addr = Val & 0x1ff;
+  unsigned Type = (Val >> 9) & 0x7;
+  unsigned Swizzle = (Val >> 12) & 0xff;
+  unsigned Mod = (Val >> 20) & 0x1f;
+
+  if (MWV208::getSrcModRel(Mod) > MWV208::REL_A0_W)
+    return MCDisassembler::Fail;
+
+  DecodeStatus S;
+  switch (Type) {
+  case MWV208::SRC_TYPE_TEMP:
+    S = decodeRegAddr(Inst, MWV208::TempRegClassRegClassID, Addr, Decoder);
+    break;
+  case MWV208::SRC_TYPE_CONST:
+    S = decodeRegAddr(Inst, MWV208::ConstRegClassRegClassID, Addr, Decoder);
+    break;
+  default:
+    return MCDisassembler::Fail;
+  }
+  if (S == MCDisassembler::Fail)
+    return S;
+
+  Inst.addOperand(MCOperand::createImm(Swizzle));
+  Inst.addOperand(MCOperand::createImm(Mod));
+  return MCDisassembler::Success;
+}
+
+// Immediate source operands, see MWV208::SrcImm. Register sources of the
+// same instruction fail on SRCn_TYPE = 7, which sends the word on to the
+// tables holding the immediate forms.
+static DecodeStatus decodeSrcImm(MCInst &Inst, uint64_t Val,
+                                 MWV208::SrcImm::Kind Kind) {
+  uint32_t Bits;
+  if (!MWV208::SrcImm::decode(Val, Kind, Bits))
+    return MCDisassembler::Fail;
+  Inst.addOperand(MCOperand::createImm(
+      Kind == MWV208::SrcImm::S20 ? int64_t(int32_t(Bits)) : int64_t(Bits)));
+  return MCDisassembler::Success;
+}
+
+static DecodeStatus decodeSrcImmI(MCInst &Inst, uint64_t Val,
+                                  uint64_t Address,
+                                  const MCDisassembler *Decoder) {
+  return decodeSrcImm(Inst, Val, MWV208::SrcImm::S20);
+}
+
+static DecodeStatus decodeSrcImmF(MCInst &Inst, uint64_t Val,
+                                  uint64_t Address,
+                                  const MCDisassembler *Decoder) {
+  return decodeSrcImm(Inst, Val, MWV208::SrcImm::F20);
+}
+
+// Predicates are {SRC2_SWIZZLE[25:18], SRC2_TYPE[17:15], SRC2_ADR[14:6],
+// SRC2_VALID[5], CONDITION_CODE[4:0]} and decode to the (cc, reg) pair of
+// Mwv208Pred. The tested component is a temp register read through a splat.
+static DecodeStatus decodePredicate(MCInst &Inst, uint64_t Val,
+                                    uint64_t Address,
+                                    const MCDisassembler *Decoder) {
+  unsigned CC = Val & 0x1f;
+  bool Valid = (Val >> 5) & 0x1;
+  unsigned Addr = (Val >> 6) & 0x1ff;
+  unsigned Type = (Val >> 15) & 0x7;
+  unsigned Swizzle = (Val >> 18) & 0xff;
+
+  if (CC > MWV208::COND_NE || Valid != (CC != MWV208::COND_TRUE))
+    return MCDisassembler::Fail;
+  Inst.addOperand(MCOperand::createImm(CC));
+  if (CC == MWV208::COND_TRUE) {
+    Inst.addOperand(MCOperand::createReg(MCRegister()));
+    return MCDisassembler::Success;
+  }
+
+  unsigned Lane = MWV208::Swizzle::getComponent(Swizzle, 0);
+  if (Type != MWV208::SRC_TYPE_TEMP ||
+      Swizzle != MWV208::Swizzle::splat(Lane))
+    return MCDisassembler::Fail;
+  return decodeRegAddr(Inst, MWV208::Component32RegClassID, Addr * 4 + Lane,
+                       Decoder);
+}
+
+// DEST_REL_ADR of the mov with a relative destination. Zero is the plain
+// mov, which is decoded from the main table.
+static DecodeStatus decodeDstRel(MCInst &Inst, uint64_t Val, uint64_t Address,
+                                 const MCDisassembler *Decoder) {
+  if (Val == MWV208::REL_NONE || Val > MWV208::REL_A0_W)
+    return MCDisassembler::Fail;
+  Inst.addOperand(MCOperand::createImm(Val));
+  return MCDisassembler::Success;
+}
+
+// Branch and hardware loop targets are signed instruction offsets from the
+// instruction.
+static DecodeStatus decodeBrTarget(MCInst &Inst, uint64_t Val,
+                                   uint64_t Address,
+                                   const MCDisassembler *Decoder) {
+  Inst.addOperand(MCOperand::createImm(SignExtend64<20>(Val)));
+  return MCDisassembler::Success;
+}
+
+#include "Mwv208GenDisassemblerTables.inc"
+
+// Instruction words are stored word 0 (Inst{31-0}) first, each word in the
+// target byte order. This mirrors Mwv208MCCodeEmitter::encodeInstruction.
+static Mwv208InsnWord readInstruction128(ArrayRef<uint8_t> Bytes,
+                                         bool IsLittleEndian) {
+  uint32_t W[4];
+  for (unsigned I = 0; I != 4; ++I)
+    W[I] = IsLittleEndian
+               ? support::endian::read32le(Bytes.data() + I * 4)
+               : support::endian::read32be(Bytes.data() + I * 4);
+  return Mwv208InsnWord(uint64_t(W[1]) << 32 | W[0],
+                        uint64_t(W[3]) << 32 | W[2]);
+}
+
+DecodeStatus Mwv208Disassembler::decode(MCInst &Instr, ArrayRef<uint8_t> Bytes,
+                                        uint64_t Address) const {
+  Mwv208InsnWord Insn =
+      readInstruction128(Bytes, getContext().getAsmInfo()->isLittleEndian());
+  // Register and immediate forms share their encoding up to SRCn_TYPE, so
+  // they are kept in separate tables: all registers, an immediate src1, an
+  // immediate src0. The mov with a relative destination only differs from
+  // the plain one in DEST_REL_ADR and has a table of its own as well.
+  for (const uint8_t *Table :
+       {DecoderTable128, DecoderTableSrcImm1128, DecoderTableSrcImm0128,
+        DecoderTableRelDst128}) {
+    DecodeStatus S =
+        decodeInstruction(Table, Instr, Insn, Address, this, STI);
+    if (S != MCDisassembler::Fail)
+      return S;
+    Instr.clear();
+  }
+  return MCDisassembler::Fail;
+}
+
 DecodeStatus Mwv208Disassembler::getInstruction(MCInst &Instr, uint64_t &Size,
                                                 ArrayRef<uint8_t> Bytes,
                                                 uint64_t Address,
                                                 raw_ostream &CStream) const {
-  return MCDisassembler::Fail;
+  // Every MWV208 instruction is 128 bits wide.
+  if (Bytes.size() < 16) {
+    Size = 0;
+    return MCDisassembler::Fail;
+  }
+
+  Size = 16;
+  return decode(Instr, Bytes, Address);
+}
+
+void Mwv208Disassembler::decodeSection(ArrayRef<uint8_t> Bytes,
+                                       uint64_t Address,
+                                       Mwv208DecodedSection &Out) const {
+  // A trailing partial word is an entry of its own, see below.
+  size_t NumInsts = divideCeil(Bytes.size(), 16);
+  Out.Insts.clear();
+  Out.Operands.clear();
+  Out.Insts.reserve(NumInsts);
+  // A general format instruction has at most a destination and three
+  // (reg, swizzle, mod) sources; reserve for the common two-source case.
+  Out.Operands.reserve(NumInsts * 7);
+
+  MCInst Scratch;
+  for (size_t I = 0; I != NumInsts; ++I) {
+    Mwv208DecodedInst &D = Out.Insts.emplace_back();
+    D.Address = Address + I * 16;
+    D.FirstOperand = Out.Operands.size();
+
+    // decodeInstruction() clears the operand list but keeps its storage, so
+    // after the first few instructions this never touches the heap.
+    Scratch.clear();
+    if (Bytes.size() - I * 16 < 16 ||
+        decode(Scratch, Bytes.slice(I * 16, 16), D.Address) ==
+            MCDisassembler::Fail)
+      continue;
+
+    D.Valid = true;
+    D.Opcode = Scratch.getOpcode();
+    D.NumOperands = Scratch.getNumOperands();
+    Out.Operands.insert(Out.Operands.end(), Scratch.begin(), Scratch.end());
+  }
 }
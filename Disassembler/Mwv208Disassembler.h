@@ -0,0 +1,114 @@
+//===- Mwv208Disassembler.h - Disassembler for Mwv208 -------------*- C++
+//-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the Mwv208 disassembler, including a bulk mode that
+// decodes a whole code section into a flat array.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_MWV208_DISASSEMBLER_MWV208DISASSEMBLER_H
+#define LLVM_LIB_TARGET_MWV208_DISASSEMBLER_MWV208DISASSEMBLER_H
+
+#include "llvm/ADT/APInt.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/MC/MCDisassembler/MCDisassembler.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+
+/// A 128-bit instruction word for the TableGen'erated decoder. Unlike APInt
+/// it never allocates, which keeps bulk decoding free of heap traffic.
+class Mwv208InsnWord {
+  uint64_t Lo = 0;
+  uint64_t Hi = 0;
+
+public:
+  Mwv208InsnWord() = default;
+  Mwv208InsnWord(uint64_t Lo, uint64_t Hi = 0) : Lo(Lo), Hi(Hi) {}
+
+  explicit operator bool() const { return Lo || Hi; }
+
+  uint64_t extractBitsAsZExtValue(unsigned NumBits,
+                                  unsigned BitPosition) const {
+    assert(NumBits && NumBits <= 64 && BitPosition < 128);
+    uint64_t Val;
+    if (BitPosition == 0)
+      Val = Lo;
+    else if (BitPosition < 64)
+      Val = Lo >> BitPosition | Hi << (64 - BitPosition);
+    else
+      Val = Hi >> (BitPosition - 64);
+    return NumBits == 64 ? Val : Val & ((uint64_t(1) << NumBits) - 1);
+  }
+
+  Mwv208InsnWord operator&(const Mwv208InsnWord &RHS) const {
+    return {Lo & RHS.Lo, Hi & RHS.Hi};
+  }
+  Mwv208InsnWord operator~() const { return {~Lo, ~Hi}; }
+  bool operator==(const Mwv208InsnWord &RHS) const {
+    return Lo == RHS.Lo && Hi == RHS.Hi;
+  }
+  bool operator!=(const Mwv208InsnWord &RHS) const { return !(*this == RHS); }
+
+  friend raw_ostream &operator<<(raw_ostream &OS, const Mwv208InsnWord &W) {
+    return OS << APInt(128, {W.Lo, W.Hi});
+  }
+};
+
+/// One entry of a bulk-decoded section. The operands live in the operand
+/// pool of the owning Mwv208DecodedSection.
+struct Mwv208DecodedInst {
+  uint64_t Address = 0;
+  unsigned Opcode = 0;
+  unsigned FirstOperand = 0;
+  unsigned NumOperands = 0;
+  bool Valid = false;
+};
+
+/// The result of Mwv208Disassembler::decodeSection.
+struct Mwv208DecodedSection {
+  std::vector<Mwv208DecodedInst> Insts;
+  std::vector<MCOperand> Operands;
+
+  ArrayRef<MCOperand> operands(const Mwv208DecodedInst &I) const {
+    return ArrayRef<MCOperand>(Operands).slice(I.FirstOperand, I.NumOperands);
+  }
+};
+
+/// A disassembler class for Mwv208.
+class Mwv208Disassembler : public MCDisassembler {
+public:
+  Mwv208Disassembler(const MCSubtargetInfo &STI, MCContext &Ctx)
+      : MCDisassembler(STI, Ctx) {}
+  virtual ~Mwv208Disassembler() = default;
+
+  DecodeStatus getInstruction(MCInst &Instr, uint64_t &Size,
+                              ArrayRef<uint8_t> Bytes, uint64_t Address,
+                              raw_ostream &CStream) const override;
+
+  /// Decode every instruction of \p Bytes, which starts at \p Address, into
+  /// \p Out. A single scratch MCInst is reused for the whole section and the
+  /// operands are appended to one flat pool, so the cost per instruction is
+  /// the table walk alone. Undecodable words, and a trailing partial
+  /// word, produce an entry with Valid unset so that PC samples still map
+  /// one-to-one onto entries.
+  void decodeSection(ArrayRef<uint8_t> Bytes, uint64_t Address,
+                     Mwv208DecodedSection &Out) const;
+
+private:
+  DecodeStatus decode(MCInst &Instr, ArrayRef<uint8_t> Bytes,
+                      uint64_t Address) const;
+};
+
+} // end namespace llvm
+
+#endif // LLVM_LIB_TARGET_MWV208_DISASSEMBLER_MWV208DISASSEMBLER_H
@@ -112,6 +112,12 @@ static unsigned adjustFixupValue(unsigned Kind, uint64_t Value) {
   case Mwv208::fixup_mwv208_gotdata_hix22:
   case Mwv208::fixup_mwv208_gotdata_op:
     return 0;
+
+  case Mwv208::fixup_mwv208_br20:
+    // The fixup sits on the last word of the instruction, see
+    // Mwv208MCCodeEmitter::getBrTargetOpValue, but the offset counts
+    // instructions from the start of this one. Target is Inst{122-103}.
+    return (((int64_t(Value) + 12) >> 4) & 0xfffff) << 7;
   }
 }
 
@@ -209,6 +215,7 @@ public:
         {"fixup_mwv208_gotdata_hix22", 0, 0, 0},
         {"fixup_mwv208_gotdata_lox10", 0, 0, 0},
         {"fixup_mwv208_gotdata_op", 0, 0, 0},
+        {"fixup_mwv208_br20", 5, 20, MCFixupKindInfo::FKF_IsPCRel},
     };
 
     const static MCFixupKindInfo InfosLE[Mwv208::NumTargetFixupKinds] = {
@@ -255,6 +262,7 @@ public:
         {"fixup_mwv208_gotdata_hix22", 0, 0, 0},
         {"fixup_mwv208_gotdata_lox10", 0, 0, 0},
         {"fixup_mwv208_gotdata_op", 0, 0, 0},
+        {"fixup_mwv208_br20", 7, 20, MCFixupKindInfo::FKF_IsPCRel},
     };
 
     // Fixup kinds from .reloc directive are like R_MWV208_NONE. They do
@@ -0,0 +1,192 @@
+//===-- Mwv208BaseInfo.h - Top level definitions for MWV208 MC ----*- C++
+//-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains small standalone helper functions and enum definitions
+// for the MWV208 instruction encoding, shared by the MC layer, the
+// disassembler and the code generator.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_MWV208_MCTARGETDESC_MWV208BASEINFO_H
+#define LLVM_LIB_TARGET_MWV208_MCTARGETDESC_MWV208BASEINFO_H
+
+#include "llvm/Support/ErrorHandling.h"
+#include <cstdint>
+
+namespace llvm {
+
+/// Target specific flags in MCInstrDesc::TSFlags, see MWV208Inst in
+/// Mwv208InstrFormats.td.
+namespace MWV208II {
+enum : uint64_t {
+  /// One of the input operands is the SATURATE bit: the last one, or the one
+  /// right before the predicate of predicable instructions.
+  HasSaturate = 1 << 0,
+  /// A texture sample, see MWV208GFSampleInst.
+  IsSample = 1 << 1,
+};
+} // end namespace MWV208II
+
+namespace MWV208 {
+
+/// Operand types as encoded in SRCn_TYPE. Registers carry their type in
+/// HWEncoding{11-9}, see Mwv208RegisterInfo.td.
+enum SrcType : unsigned {
+  SRC_TYPE_TEMP = 0x0,
+  SRC_TYPE_CONST = 0x1,
+  SRC_TYPE_IMM = 0x7,
+};
+
+/// Layout of the 'mod' sub-operand of a source operand.
+namespace SrcMod {
+enum : unsigned {
+  NEG = 1u << 0,       // SRCn_MODIFIER_NEG
+  ABS = 1u << 1,       // SRCn_MODIFIER_ABS
+  REL_SHIFT = 2,       // SRCn_REL_ADR
+  REL_MASK = 0x7u << REL_SHIFT,
+};
+} // end namespace SrcMod
+
+/// Values of the 3-bit REL_ADR fields. Zero means absolute addressing,
+/// otherwise the register address is offset by a component of a0.
+enum RelAdr : unsigned {
+  REL_NONE = 0,
+  REL_A0_X = 1,
+  REL_A0_Y = 2,
+  REL_A0_Z = 3,
+  REL_A0_W = 4,
+};
+
+inline unsigned getSrcModRel(unsigned Mod) {
+  return (Mod & SrcMod::REL_MASK) >> SrcMod::REL_SHIFT;
+}
+
+/// Immediate source operands (SRCn_TYPE = 7) hold a 20-bit value that is
+/// broadcast to every lane. The value is split around the type field:
+/// {KIND[24-23], VALUE[19-9], TYPE[11-9], VALUE[8-0]}, KIND taking the place
+/// of the modifier bits. The MCInst operand keeps the full 32-bit value.
+namespace SrcImm {
+enum Kind : unsigned {
+  F20 = 0, // The high 20 bits of an f32, the low 12 mantissa bits are zero.
+  S20 = 1, // A sign-extended 20-bit integer.
+};
+
+inline bool isEncodable(Kind K, uint32_t Bits) {
+  if (K == F20)
+    return (Bits & 0xfff) == 0;
+  int32_t V = static_cast<int32_t>(Bits);
+  return V >= -(1 << 19) && V < (1 << 19);
+}
+
+inline uint64_t encode(Kind K, uint32_t Bits) {
+  uint32_t V = K == F20 ? Bits >> 12 : Bits & 0xfffff;
+  return (V & 0x1ff) | uint64_t(SRC_TYPE_IMM) << 9 | uint64_t(V >> 9) << 12 |
+         uint64_t(K) << 23;
+}
+
+/// Recover the 32-bit value of an immediate of kind \p K, failing when
+/// \p Enc is not such an immediate.
+inline bool decode(uint64_t Enc, Kind K, uint32_t &Bits) {
+  if (((Enc >> 9) & 0x7) != SRC_TYPE_IMM || ((Enc >> 23) & 0x3) != K)
+    return false;
+  uint32_t V = (Enc & 0x1ff) | ((Enc >> 12) & 0x7ff) << 9;
+  Bits = K == F20 ? V << 12 : static_cast<uint32_t>(int32_t(V << 12) >> 12);
+  return true;
+}
+} // end namespace SrcImm
+
+/// Values of CONDITION_CODE. Comparisons write all ones to the lanes where
+/// the condition holds and zero elsewhere.
+enum CondCode : unsigned {
+  COND_TRUE = 0,
+  COND_GT = 1,
+  COND_LT = 2,
+  COND_GE = 3,
+  COND_LE = 4,
+  COND_EQ = 5,
+  COND_NE = 6,
+};
+
+/// The condition holding exactly where \p CC does not.
+inline CondCode getOppositeCondition(CondCode CC) {
+  switch (CC) {
+  default:
+    llvm_unreachable("Condition has no opposite");
+  case COND_GT:
+    return COND_LE;
+  case COND_LE:
+    return COND_GT;
+  case COND_LT:
+    return COND_GE;
+  case COND_GE:
+    return COND_LT;
+  case COND_EQ:
+    return COND_NE;
+  case COND_NE:
+    return COND_EQ;
+  }
+}
+
+/// Destination write mask (DEST_WRITE_ENABLE) of a register, taken from its
+/// HWEncoding. Bit 0 enables component x.
+inline unsigned getWriteMask(uint16_t HWEncoding) {
+  return (HWEncoding >> 12) & 0xf;
+}
+
+/// Return the lane of a component register (r0.x ... r511.w) given its
+/// HWEncoding, or -1 for a whole 128-bit register.
+inline int getComponentLane(uint16_t HWEncoding) {
+  switch (getWriteMask(HWEncoding)) {
+  case 0x1:
+    return 0;
+  case 0x2:
+    return 1;
+  case 0x4:
+    return 2;
+  case 0x8:
+    return 3;
+  default:
+    return -1;
+  }
+}
+
+/// Source swizzles use two bits per result component, component 0 (x) in the
+/// low bits. x=0 y=1 z=2 w=3.
+namespace Swizzle {
+enum : unsigned {
+  XXXX = 0x00,
+  XYZW = 0xe4,
+};
+
+inline unsigned getComponent(unsigned Swz, unsigned Lane) {
+  return (Swz >> (Lane * 2)) & 0x3;
+}
+
+inline unsigned setComponent(unsigned Swz, unsigned Lane, unsigned Comp) {
+  return (Swz & ~(0x3u << (Lane * 2))) | ((Comp & 0x3) << (Lane * 2));
+}
+
+/// A swizzle that reads component \p Comp in every lane.
+inline unsigned splat(unsigned Comp) { return (Comp & 0x3) * 0x55; }
+
+/// The swizzle reading \p Outer of a value that is itself \p Inner of a
+/// register.
+inline unsigned compose(unsigned Inner, unsigned Outer) {
+  unsigned Swz = 0;
+  for (unsigned Lane = 0; Lane != 4; ++Lane)
+    Swz = setComponent(Swz, Lane,
+                       getComponent(Inner, getComponent(Outer, Lane)));
+  return Swz;
+}
+} // end namespace Swizzle
+
+} // end namespace MWV208
+} // end namespace llvm
+
+#endif // LLVM_LIB_TARGET_MWV208_MCTARGETDESC_MWV208BASEINFO_H
@@ -107,6 +107,10 @@ enum Fixups {
   /// 32-bit fixup corresponding to %gdop(foo)
   fixup_mwv208_gotdata_op,
 
+  /// fixup_mwv208_br20 - 20-bit instruction offset in the Target field of
+  /// the branch and hardware loop instructions, relative to the instruction.
+  fixup_mwv208_br20,
+
   // Marker
   LastTargetFixupKind,
   NumTargetFixupKinds = LastTargetFixupKind - FirstTargetFixupKind
@@ -13,11 +13,16 @@
 
 #include "Mwv208InstPrinter.h"
 #include "Mwv208.h"
+#include "Mwv208BaseInfo.h"
+#include "llvm/ADT/bit.h"
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/MCSymbol.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/raw_ostream.h"
+#include <iterator>
 using namespace llvm;
 
 #define DEBUG_TYPE "asm-printer"
@@ -165,6 +170,130 @@ void Mwv208InstPrinter::printOperand(const MCInst *MI, int opNum,
   MO.getExpr()->print(O, &MAI);
 }
 
+// A relative address is printed as [a0.c], c being the component of a0
+// selected by a REL_ADR field.
+static void printRelAdr(unsigned Rel, raw_ostream &O) {
+  O << "[a0." << "xyzw"[(Rel - MWV208::REL_A0_X) & 0x3] << ']';
+}
+
+// A source operand is printed as [-][|]%reg[[a0.c]][.swizzle][|].
+void Mwv208InstPrinter::printSrcOperand(const MCInst *MI, int opNum,
+                                        const MCSubtargetInfo &STI,
+                                        raw_ostream &O) {
+  unsigned Swizzle = MI->getOperand(opNum + 1).getImm();
+  unsigned Mod = MI->getOperand(opNum + 2).getImm();
+
+  if (Mod & MWV208::SrcMod::NEG)
+    O << '-';
+  if (Mod & MWV208::SrcMod::ABS)
+    O << '|';
+
+  // A component register is printed the way it is encoded: as its parent
+  // register with a splat swizzle.
+  const MCOperand &Op = MI->getOperand(opNum);
+  int Lane = Op.isReg() ? MWV208::getComponentLane(
+                              MRI.getEncodingValue(Op.getReg()))
+                        : -1;
+  if (Lane >= 0) {
+    printRegName(O, *MRI.superregs(Op.getReg()).begin());
+    Swizzle = MWV208::Swizzle::splat(Lane);
+  } else {
+    printOperand(MI, opNum, STI, O);
+  }
+
+  if (unsigned Rel = MWV208::getSrcModRel(Mod))
+    printRelAdr(Rel, O);
+
+  if (Swizzle != MWV208::Swizzle::XYZW)
+    printSwizzle(Swizzle, O);
+
+  if (Mod & MWV208::SrcMod::ABS)
+    O << '|';
+}
+
+void Mwv208InstPrinter::printSwizzle(unsigned Swizzle, raw_ostream &O) {
+  O << '.';
+  for (unsigned Lane = 0; Lane != 4; ++Lane)
+    O << "xyzw"[MWV208::Swizzle::getComponent(Swizzle, Lane)];
+}
+
+void Mwv208InstPrinter::printSrcImmI(const MCInst *MI, int opNum,
+                                     const MCSubtargetInfo &STI,
+                                     raw_ostream &O) {
+  O << static_cast<int32_t>(MI->getOperand(opNum).getImm());
+}
+
+void Mwv208InstPrinter::printSrcImmF(const MCInst *MI, int opNum,
+                                     const MCSubtargetInfo &STI,
+                                     raw_ostream &O) {
+  uint32_t Bits = static_cast<uint32_t>(MI->getOperand(opNum).getImm());
+  O << format("%g", bit_cast<float>(Bits));
+}
+
+static const char *getCondCodeSuffix(unsigned CC) {
+  static const char *const Names[] = {"",    ".gt", ".lt", ".ge",
+                                      ".le", ".eq", ".ne"};
+  assert(CC < std::size(Names) && "Unknown condition code");
+  return Names[CC];
+}
+
+void Mwv208InstPrinter::printCondCode(const MCInst *MI, int opNum,
+                                      const MCSubtargetInfo &STI,
+                                      raw_ostream &O) {
+  O << getCondCodeSuffix(MI->getOperand(opNum).getImm());
+}
+
+// A predicate is printed as a mnemonic suffix naming the condition and the
+// tested component, e.g. "add.s32.ne(%r3.x)". Unpredicated instructions print
+// nothing.
+void Mwv208InstPrinter::printPredicate(const MCInst *MI, int opNum,
+                                       const MCSubtargetInfo &STI,
+                                       raw_ostream &O) {
+  unsigned CC = MI->getOperand(opNum).getImm();
+  if (CC == MWV208::COND_TRUE)
+    return;
+  O << getCondCodeSuffix(CC) << '(';
+  printRegName(O, MI->getOperand(opNum + 1).getReg());
+  O << ')';
+}
+
+// The saturate bit is printed as a mnemonic suffix, e.g. "add.f32.sat".
+void Mwv208InstPrinter::printSaturate(const MCInst *MI, int opNum,
+                                      const MCSubtargetInfo &STI,
+                                      raw_ostream &O) {
+  if (MI->getOperand(opNum).getImm())
+    O << ".sat";
+}
+
+void Mwv208InstPrinter::printDstRel(const MCInst *MI, int opNum,
+                                    const MCSubtargetInfo &STI,
+                                    raw_ostream &O) {
+  printRelAdr(MI->getOperand(opNum).getImm(), O);
+}
+
+void Mwv208InstPrinter::printSampler(const MCInst *MI, int opNum,
+                                     const MCSubtargetInfo &STI,
+                                     raw_ostream &O) {
+  O << 's' << MI->getOperand(opNum).getImm();
+}
+
+// SAMPLER_SWIZZLE, printed like a source swizzle on the sampler when it is
+// not the identity, e.g. "tex r1, r0, s2.wzyx".
+void Mwv208InstPrinter::printSwizzleOp(const MCInst *MI, int opNum,
+                                       const MCSubtargetInfo &STI,
+                                       raw_ostream &O) {
+  unsigned Swizzle = MI->getOperand(opNum).getImm();
+  if (Swizzle != MWV208::Swizzle::XYZW)
+    printSwizzle(Swizzle, O);
+}
+
+// The component gathered by gather4, printed as a mnemonic suffix.
+void Mwv208InstPrinter::printComponent(const MCInst *MI, int opNum,
+                                       const MCSubtargetInfo &STI,
+                                       raw_ostream &O) {
+  O << '.' << "xyzw"[MI->getOperand(opNum).getImm() & 0x3];
+}
+
 void Mwv208InstPrinter::printMemOperand(const MCInst *MI, int opNum,
                                         const MCSubtargetInfo &STI,
                                         raw_ostream &O) {
@@ -46,6 +46,27 @@ public:
 
   void printOperand(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
                     raw_ostream &OS);
+  void printSrcOperand(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                       raw_ostream &OS);
+  void printSwizzle(unsigned Swizzle, raw_ostream &OS);
+  void printSrcImmI(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                    raw_ostream &OS);
+  void printSrcImmF(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                    raw_ostream &OS);
+  void printCondCode(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                     raw_ostream &OS);
+  void printPredicate(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                      raw_ostream &OS);
+  void printSaturate(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                     raw_ostream &OS);
+  void printDstRel(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                   raw_ostream &OS);
+  void printSampler(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                    raw_ostream &OS);
+  void printSwizzleOp(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                      raw_ostream &OS);
+  void printComponent(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
+                      raw_ostream &OS);
   void printMemOperand(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
                        raw_ostream &OS);
   void printCCOperand(const MCInst *MI, int opNum, const MCSubtargetInfo &STI,
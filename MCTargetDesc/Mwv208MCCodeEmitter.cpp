@@ -11,9 +11,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "MCTargetDesc/Mwv208BaseInfo.h"
 #include "MCTargetDesc/Mwv208FixupKinds.h"
 #include "Mwv208MCExpr.h"
 #include "Mwv208MCTargetDesc.h"
+#include "llvm/ADT/APInt.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/MC/MCAsmInfo.h"
@@ -55,31 +57,54 @@ public:
                          const MCSubtargetInfo &STI) const override;
 
   // getBinaryCodeForInstr - TableGen'erated function for getting the
-  // binary encoding for an instruction.
-  uint64_t getBinaryCodeForInstr(const MCInst &MI,
-                                 SmallVectorImpl<MCFixup> &Fixups,
-                                 const MCSubtargetInfo &STI) const;
+  // binary encoding for an instruction. Every MWV208 instruction is 128 bits
+  // wide, so the encoding is built in an APInt rather than a uint64_t.
+  void getBinaryCodeForInstr(const MCInst &MI, SmallVectorImpl<MCFixup> &Fixups,
+                             APInt &Inst, APInt &Scratch,
+                             const MCSubtargetInfo &STI) const;
 
   /// getMachineOpValue - Return binary encoding of operand. If the machine
   /// operand requires relocation, record the relocation and return zero.
-  unsigned getMachineOpValue(const MCInst &MI, const MCOperand &MO,
+  void getMachineOpValue(const MCInst &MI, const MCOperand &MO, APInt &Op,
+                         SmallVectorImpl<MCFixup> &Fixups,
+                         const MCSubtargetInfo &STI) const;
+  uint64_t getMachineOpValue(const MCInst &MI, const MCOperand &MO,
                              SmallVectorImpl<MCFixup> &Fixups,
                              const MCSubtargetInfo &STI) const;
-  unsigned getCallTargetOpValue(const MCInst &MI, unsigned OpNo,
-                                SmallVectorImpl<MCFixup> &Fixups,
-                                const MCSubtargetInfo &STI) const;
-  unsigned getBranchTargetOpValue(const MCInst &MI, unsigned OpNo,
-                                  SmallVectorImpl<MCFixup> &Fixups,
-                                  const MCSubtargetInfo &STI) const;
-  unsigned getSImm13OpValue(const MCInst &MI, unsigned OpNo,
-                            SmallVectorImpl<MCFixup> &Fixups,
-                            const MCSubtargetInfo &STI) const;
-  unsigned getBranchPredTargetOpValue(const MCInst &MI, unsigned OpNo,
-                                      SmallVectorImpl<MCFixup> &Fixups,
-                                      const MCSubtargetInfo &STI) const;
-  unsigned getBranchOnRegTargetOpValue(const MCInst &MI, unsigned OpNo,
-                                       SmallVectorImpl<MCFixup> &Fixups,
-                                       const MCSubtargetInfo &STI) const;
+
+  /// getSrcOpValue - Return the encoding of a (reg, swizzle, mod) source
+  /// operand as {REL_ADR, ABS, NEG, SWIZZLE, TYPE, ADR}.
+  void getSrcOpValue(const MCInst &MI, unsigned OpNo, APInt &Op,
+                     SmallVectorImpl<MCFixup> &Fixups,
+                     const MCSubtargetInfo &STI) const;
+
+  /// getSrcImmIOpValue/getSrcImmFOpValue - Return the encoding of an integer
+  /// or f32 immediate source operand, see MWV208::SrcImm.
+  void getSrcImmIOpValue(const MCInst &MI, unsigned OpNo, APInt &Op,
+                         SmallVectorImpl<MCFixup> &Fixups,
+                         const MCSubtargetInfo &STI) const {
+    getSrcImmOpValue(MI, OpNo, MWV208::SrcImm::S20, Op);
+  }
+  void getSrcImmFOpValue(const MCInst &MI, unsigned OpNo, APInt &Op,
+                         SmallVectorImpl<MCFixup> &Fixups,
+                         const MCSubtargetInfo &STI) const {
+    getSrcImmOpValue(MI, OpNo, MWV208::SrcImm::F20, Op);
+  }
+  void getSrcImmOpValue(const MCInst &MI, unsigned OpNo,
+                        MWV208::SrcImm::Kind Kind, APInt &Op) const;
+
+  /// getBrTargetOpValue - Return the Target field of a branch or hardware
+  /// loop instruction, recording a fixup for a label.
+  void getBrTargetOpValue(const MCInst &MI, unsigned OpNo, APInt &Op,
+                          SmallVectorImpl<MCFixup> &Fixups,
+                          const MCSubtargetInfo &STI) const;
+
+  /// getPredOpValue - Return the predicate fields of a predicable
+  /// instruction: {SRC2_SWIZZLE, SRC2_TYPE, SRC2_ADR, SRC2_VALID,
+  /// CONDITION_CODE}.
+  void getPredOpValue(const MCInst &MI, unsigned OpNo, APInt &Op,
+                      SmallVectorImpl<MCFixup> &Fixups,
+                      const MCSubtargetInfo &STI) const;
 };
 
 } // end anonymous namespace
@@ -88,42 +113,107 @@ void Mwv208MCCodeEmitter::encodeInstruction(const MCInst &MI,
                                             SmallVectorImpl<char> &CB,
                                             SmallVectorImpl<MCFixup> &Fixups,
                                             const MCSubtargetInfo &STI) const {
-  unsigned Bits = getBinaryCodeForInstr(MI, Fixups, STI);
-  support::endian::write(CB, Bits,
-                         Ctx.getAsmInfo()->isLittleEndian()
-                             ? llvm::endianness::little
-                             : llvm::endianness::big);
-
-  // Some instructions have phantom operands that only contribute a fixup entry.
-  unsigned SymOpNo = 0;
-  switch (MI.getOpcode()) {
-  default:
-    break;
-  case MWV208::TLS_CALL:
-    SymOpNo = 1;
-    break;
-  case MWV208::GDOP_LDrr:
-  case MWV208::GDOP_LDXrr:
-  case MWV208::TLS_ADDrr:
-  case MWV208::TLS_LDrr:
-  case MWV208::TLS_LDXrr:
-    SymOpNo = 3;
-    break;
+  APInt Inst(128, 0), Scratch(128, 0);
+  getBinaryCodeForInstr(MI, Fixups, Inst, Scratch, STI);
+
+  // Emit the four 32-bit instruction words in order, word 0 (Inst{31-0})
+  // first. Each word follows the endianness of the target.
+  const llvm::endianness E = Ctx.getAsmInfo()->isLittleEndian()
+                                 ? llvm::endianness::little
+                                 : llvm::endianness::big;
+  for (unsigned Word = 0; Word != 4; ++Word)
+    support::endian::write<uint32_t>(
+        CB, static_cast<uint32_t>(Inst.extractBitsAsZExtValue(32, Word * 32)),
+        E);
+
+  ++MCNumEmitted; // Keep track of the # of mi's emitted.
+}
+
+void Mwv208MCCodeEmitter::getMachineOpValue(const MCInst &MI,
+                                            const MCOperand &MO, APInt &Op,
+                                            SmallVectorImpl<MCFixup> &Fixups,
+                                            const MCSubtargetInfo &STI) const {
+  Op = getMachineOpValue(MI, MO, Fixups, STI);
+}
+
+void Mwv208MCCodeEmitter::getSrcOpValue(const MCInst &MI, unsigned OpNo,
+                                        APInt &Op,
+                                        SmallVectorImpl<MCFixup> &Fixups,
+                                        const MCSubtargetInfo &STI) const {
+  const MCOperand &Reg = MI.getOperand(OpNo);
+  const MCOperand &Swz = MI.getOperand(OpNo + 1);
+  const MCOperand &Mod = MI.getOperand(OpNo + 2);
+
+  uint64_t RegEnc = getMachineOpValue(MI, Reg, Fixups, STI);
+  unsigned Swizzle = Swz.getImm() & 0xff;
+  // A component register is its parent register read through a splat of
+  // its lane; the address bits are shared.
+  if (Reg.isReg()) {
+    int Lane = MWV208::getComponentLane(RegEnc);
+    if (Lane >= 0)
+      Swizzle = MWV208::Swizzle::splat(Lane);
   }
-  if (SymOpNo != 0) {
-    const MCOperand &MO = MI.getOperand(SymOpNo);
-    uint64_t op = getMachineOpValue(MI, MO, Fixups, STI);
-    assert(op == 0 && "Unexpected operand value!");
-    (void)op; // suppress warning.
+
+  uint64_t Enc = RegEnc & 0xfff;
+  Enc |= uint64_t(Swizzle) << 12;
+  Enc |= (Mod.getImm() & 0x1f) << 20;
+  Op = Enc;
+}
+
+void Mwv208MCCodeEmitter::getSrcImmOpValue(const MCInst &MI, unsigned OpNo,
+                                           MWV208::SrcImm::Kind Kind,
+                                           APInt &Op) const {
+  uint32_t Bits = static_cast<uint32_t>(MI.getOperand(OpNo).getImm());
+  assert(MWV208::SrcImm::isEncodable(Kind, Bits) &&
+         "Immediate does not fit a source operand");
+  Op = MWV208::SrcImm::encode(Kind, Bits);
+}
+
+void Mwv208MCCodeEmitter::getBrTargetOpValue(const MCInst &MI, unsigned OpNo,
+                                             APInt &Op,
+                                             SmallVectorImpl<MCFixup> &Fixups,
+                                             const MCSubtargetInfo &STI) const {
+  const MCOperand &MO = MI.getOperand(OpNo);
+  if (MO.isImm()) {
+    Op = MO.getImm() & 0xfffff;
+    return;
   }
 
-  ++MCNumEmitted; // Keep track of the # of mi's emitted.
+  // Target is Inst{122-103}, inside word 3.
+  Fixups.push_back(MCFixup::create(
+      12, MO.getExpr(), static_cast<MCFixupKind>(Mwv208::fixup_mwv208_br20)));
+  Op = 0;
 }
 
-unsigned
+void Mwv208MCCodeEmitter::getPredOpValue(const MCInst &MI, unsigned OpNo,
+                                         APInt &Op,
+                                         SmallVectorImpl<MCFixup> &Fixups,
+                                         const MCSubtargetInfo &STI) const {
+  unsigned CC = MI.getOperand(OpNo).getImm() & 0x1f;
+  const MCOperand &Reg = MI.getOperand(OpNo + 1);
+  if (CC == MWV208::COND_TRUE || !Reg.isReg() || !Reg.getReg()) {
+    Op = 0;
+    return;
+  }
+
+  // The predicate is a component register, read through a splat of its lane
+  // like any other scalar source.
+  uint64_t RegEnc = getMachineOpValue(MI, Reg, Fixups, STI);
+  int Lane = MWV208::getComponentLane(RegEnc);
+  assert(Lane >= 0 && "Predicate must be a component register");
+  uint64_t Enc = CC;
+  Enc |= uint64_t(1) << 5;
+  Enc |= (RegEnc & 0xfff) << 6;
+  Enc |= uint64_t(MWV208::Swizzle::splat(Lane)) << 18;
+  Op = Enc;
+}
+
+uint64_t
 Mwv208MCCodeEmitter::getMachineOpValue(const MCInst &MI, const MCOperand &MO,
                                        SmallVectorImpl<MCFixup> &Fixups,
                                        const MCSubtargetInfo &STI) const {
+  // Register encodings already carry the operand type in HWEncoding{11-9},
+  // see Mwv208RegisterInfo.td.
   if (MO.isReg())
     return Ctx.getRegisterInfo()->getEncodingValue(MO.getReg());
 
@@ -146,102 +236,6 @@ Mwv208MCCodeEmitter::getMachineOpValue(const MCInst &MI, const MCOperand &MO,
   return 0;
 }
 
-unsigned
-Mwv208MCCodeEmitter::getSImm13OpValue(const MCInst &MI, unsigned OpNo,
-                                      SmallVectorImpl<MCFixup> &Fixups,
-                                      const MCSubtargetInfo &STI) const {
-  const MCOperand &MO = MI.getOperand(OpNo);
-
-  if (MO.isImm())
-    return MO.getImm();
-
-  assert(MO.isExpr() &&
-         "getSImm13OpValue expects only expressions or an immediate");
-
-  const MCExpr *Expr = MO.getExpr();
-
-  // Constant value, no fixup is needed
-  if (const MCConstantExpr *CE = dyn_cast<MCConstantExpr>(Expr))
-    return CE->getValue();
-
-  MCFixupKind Kind;
-  if (const Mwv208MCExpr *SExpr = dyn_cast<Mwv208MCExpr>(Expr)) {
-    Kind = MCFixupKind(SExpr->getFixupKind());
-  } else {
-    bool IsPic = Ctx.getObjectFileInfo()->isPositionIndependent();
-    Kind = IsPic ? MCFixupKind(Mwv208::fixup_mwv208_got13)
-                 : MCFixupKind(Mwv208::fixup_mwv208_13);
-  }
-
-  Fixups.push_back(MCFixup::create(0, Expr, Kind));
-  return 0;
-}
-
-unsigned
-Mwv208MCCodeEmitter::getCallTargetOpValue(const MCInst &MI, unsigned OpNo,
-                                          SmallVectorImpl<MCFixup> &Fixups,
-                                          const MCSubtargetInfo &STI) const {
-  const MCOperand &MO = MI.getOperand(OpNo);
-  const MCExpr *Expr = MO.getExpr();
-  const Mwv208MCExpr *SExpr = dyn_cast<Mwv208MCExpr>(Expr);
-
-  if (MI.getOpcode() == MWV208::TLS_CALL) {
-    // No fixups for __tls_get_addr. Will emit for fixups for tls_symbol in
-    // encodeInstruction.
-#ifndef NDEBUG
-    // Verify that the callee is actually __tls_get_addr.
-    assert(SExpr && SExpr->getSubExpr()->getKind() == MCExpr::SymbolRef &&
-           "Unexpected expression in TLS_CALL");
-    const MCSymbolRefExpr *SymExpr = cast<MCSymbolRefExpr>(SExpr->getSubExpr());
-    assert(SymExpr->getSymbol().getName() == "__tls_get_addr" &&
-           "Unexpected function for TLS_CALL");
-#endif
-    return 0;
-  }
-
-  MCFixupKind Kind = MCFixupKind(SExpr->getFixupKind());
-  Fixups.push_back(MCFixup::create(0, Expr, Kind));
-  return 0;
-}
-
-unsigned
-Mwv208MCCodeEmitter::getBranchTargetOpValue(const MCInst &MI, unsigned OpNo,
-                                            SmallVectorImpl<MCFixup> &Fixups,
-                                            const MCSubtargetInfo &STI) const {
-  const MCOperand &MO = MI.getOperand(OpNo);
-  if (MO.isReg() || MO.isImm())
-    return getMachineOpValue(MI, MO, Fixups, STI);
-
-  Fixups.push_back(
-      MCFixup::create(0, MO.getExpr(), (MCFixupKind)Mwv208::fixup_mwv208_br22));
-  return 0;
-}
-
-unsigned Mwv208MCCodeEmitter::getBranchPredTargetOpValue(
-    const MCInst &MI, unsigned OpNo, SmallVectorImpl<MCFixup> &Fixups,
-    const MCSubtargetInfo &STI) const {
-  const MCOperand &MO = MI.getOperand(OpNo);
-  if (MO.isReg() || MO.isImm())
-    return getMachineOpValue(MI, MO, Fixups, STI);
-
-  Fixups.push_back(
-      MCFixup::create(0, MO.getExpr(), (MCFixupKind)Mwv208::fixup_mwv208_br19));
-  return 0;
-}
-
-unsigned Mwv208MCCodeEmitter::getBranchOnRegTargetOpValue(
-    const MCInst &MI, unsigned OpNo, SmallVectorImpl<MCFixup> &Fixups,
-    const MCSubtargetInfo &STI) const {
-  const MCOperand &MO = MI.getOperand(OpNo);
-  if (MO.isReg() || MO.isImm())
-    return getMachineOpValue(MI, MO, Fixups, STI);
-
-  Fixups.push_back(
-      MCFixup::create(0, MO.getExpr(), (MCFixupKind)Mwv208::fixup_mwv208_br16));
-
-  return 0;
-}
-
 #include "Mwv208GenMCCodeEmitter.inc"
 
 MCCodeEmitter *llvm::createMwv208MCCodeEmitter(const MCInstrInfo &MCII,
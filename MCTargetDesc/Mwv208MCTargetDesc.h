@@ -72,6 +72,7 @@ struct PrefetchTag {
 // Defines symbolic names for the Mwv208 instructions.
 //
 #define GET_INSTRINFO_ENUM
+#define GET_INSTRINFO_OPERAND_TYPES_ENUM
 #define GET_INSTRINFO_MC_HELPER_DECLS
 #include "Mwv208GenInstrInfo.inc"
 
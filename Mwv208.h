@@ -28,10 +28,16 @@ class PassRegistry;
 class Mwv208TargetMachine;
 
 FunctionPass *createMwv208ISelDag(Mwv208TargetMachine &TM);
+FunctionPass *createMwv208HardwareLoopsPass();
+FunctionPass *createMwv208SLPPackerPass();
+FunctionPass *createMwv208StructuredCFPass();
 
 void LowerMwv208MachineInstrToMCInst(const MachineInstr *MI, MCInst &OutMI,
                                      AsmPrinter &AP);
 void initializeMwv208DAGToDAGISelLegacyPass(PassRegistry &);
+void initializeMwv208HardwareLoopsPass(PassRegistry &);
+void initializeMwv208SLPPackerPass(PassRegistry &);
+void initializeMwv208StructuredCFPass(PassRegistry &);
 } // namespace llvm
 
 #endif
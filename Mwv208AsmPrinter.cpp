@@ -18,8 +18,12 @@
 #include "MCTargetDesc/Mwv208TargetStreamer.h"
 #include "Mwv208.h"
 #include "Mwv208InstrInfo.h"
+#include "Mwv208MachineFunctionInfo.h"
 #include "Mwv208TargetMachine.h"
 #include "TargetInfo/Mwv208TargetInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/BinaryFormat/ELF.h"
 #include "llvm/CodeGen/AsmPrinter.h"
 #include "llvm/CodeGen/MachineInstr.h"
 #include "llvm/CodeGen/MachineModuleInfoImpls.h"
@@ -29,6 +33,7 @@
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/TargetRegistry.h"
@@ -38,6 +43,11 @@ using namespace llvm;
 
 #define DEBUG_TYPE "asm-printer"
 
+STATISTIC(NumTempRegsUsed, "Number of temp registers used, summed over "
+                           "functions");
+STATISTIC(NumComponentsUsed, "Number of temp register components used, "
+                             "summed over functions");
+
 namespace {
 class Mwv208AsmPrinter : public AsmPrinter {
   Mwv208TargetStreamer &getTargetStreamer() {
@@ -53,6 +63,8 @@ public:
   StringRef getPassName() const override { return "Mwv208 Assembly Printer"; }
 
   void emitInstruction(const MachineInstr *MI) override;
+  void emitFunctionBodyEnd() override;
+  void emitConstantBank();
 
   static const char *getRegisterName(MCRegister Reg) {
     return Mwv208InstPrinter::getRegisterName(Reg);
@@ -73,6 +85,55 @@ void Mwv208AsmPrinter::emitInstruction(const MachineInstr *MI) {
   } while ((++I != E) && I->isInsideBundle()); // <--bundle: 并行指令组
 }
 
+// The number of temp registers a kernel touches bounds how many threads fit
+// on a core. Report it, and how densely the components are packed.
+void Mwv208AsmPrinter::emitFunctionBodyEnd() {
+  const MachineRegisterInfo &MRI = MF->getRegInfo();
+  const TargetRegisterInfo *TRI = MF->getSubtarget().getRegisterInfo();
+  unsigned NumRegs = 0, NumComps = 0;
+  for (MCPhysReg Reg : MWV208::TempRegClassRegClass) {
+    unsigned Comps = 0;
+    for (unsigned Lane = 0; Lane != 4; ++Lane)
+      Comps += MRI.isPhysRegUsed(
+          TRI->getSubReg(Reg, MWV208::getComponentSubReg(Lane)));
+    NumRegs += Comps != 0;
+    NumComps += Comps;
+  }
+  NumTempRegsUsed += NumRegs;
+  NumComponentsUsed += NumComps;
+
+  if (isVerbose())
+    OutStreamer->emitRawComment(" temp registers: " + Twine(NumRegs) +
+                                ", components: " + Twine(NumComps));
+
+  emitConstantBank();
+}
+
+// The driver uploads the constant bank of a kernel once per launch. Each
+// kernel gets a record in .mwv208.cbank: the kernel symbol, the number of c
+// registers used, then a (kind, value) pair per lane, see Mwv208ConstLane.
+void Mwv208AsmPrinter::emitConstantBank() {
+  const Mwv208ConstantBank &Bank =
+      MF->getInfo<Mwv208MachineFunctionInfo>()->getConstantBank();
+  if (Bank.empty())
+    return;
+
+  OutStreamer->pushSection();
+  OutStreamer->switchSection(
+      OutContext.getELFSection(".mwv208.cbank", ELF::SHT_PROGBITS, 0));
+  OutStreamer->emitValue(MCSymbolRefExpr::create(CurrentFnSym, OutContext), 4);
+  OutStreamer->emitInt32(Bank.registers().size());
+  for (auto [Idx, R] : enumerate(Bank.registers())) {
+    for (auto [Lane, L] : enumerate(R)) {
+      if (isVerbose())
+        OutStreamer->AddComment("c" + Twine(Idx) + "." + Twine("xyzw"[Lane]));
+      OutStreamer->emitInt32(L.Kind);
+      OutStreamer->emitInt32(L.Value);
+    }
+  }
+  OutStreamer->popSection();
+}
+
 // Force static initialization.
 extern "C" LLVM_EXTERNAL_VISIBILITY void LLVMInitializeMwv208AsmPrinter() {
   RegisterAsmPrinter<Mwv208AsmPrinter> X(getTheMwv208Target());
@@ -0,0 +1,99 @@
+//===-- Mwv208HardwareLoops.cpp - Finalize MWV208 hardware loops ----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Counted loops reach instruction selection as a LOOP_SETUP pseudo in the
+// preheader and an ENDLOOP at the end of the latch, see
+// Mwv208TTIImpl::isHardwareLoopProfitable. The LOOP instruction also names
+// the loop exit, which is only known once blocks are laid out, so this pass
+// runs right before emission and turns each LOOP_SETUP into a LOOP_s
+// pointing just past its ENDLOOP.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Mwv208.h"
+#include "Mwv208Subtarget.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/Support/ErrorHandling.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "mwv208-hwloops"
+#define PASS_NAME "MWV208 hardware loop finalization"
+
+namespace {
+class Mwv208HardwareLoops : public MachineFunctionPass {
+public:
+  static char ID;
+  Mwv208HardwareLoops() : MachineFunctionPass(ID) {}
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return PASS_NAME; }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+};
+} // end anonymous namespace
+
+char Mwv208HardwareLoops::ID = 0;
+
+INITIALIZE_PASS(Mwv208HardwareLoops, DEBUG_TYPE, PASS_NAME, false, false)
+
+bool Mwv208HardwareLoops::runOnMachineFunction(MachineFunction &MF) {
+  const TargetInstrInfo *TII = MF.getSubtarget().getInstrInfo();
+
+  // A loop is a run of blocks in layout order that starts right after the
+  // LOOP_SETUP and ends with the ENDLOOP; branches inside it never leave it.
+  // Pair them up like brackets.
+  SmallVector<MachineInstr *, 2> Open;
+  bool Changed = false;
+  for (MachineBasicBlock &MBB : MF) {
+    for (MachineInstr &MI : llvm::make_early_inc_range(MBB)) {
+      if (MI.getOpcode() == MWV208::LOOP_SETUP) {
+        Open.push_back(&MI);
+        continue;
+      }
+      if (MI.getOpcode() != MWV208::ENDLOOP)
+        continue;
+
+      if (Open.empty())
+        report_fatal_error("ENDLOOP without a matching LOOP_SETUP");
+      MachineInstr *Setup = Open.pop_back_val();
+      MachineBasicBlock *Preheader = Setup->getParent();
+      MachineFunction::iterator Exit = std::next(MBB.getIterator());
+      if (std::next(Preheader->getIterator()) !=
+              MI.getOperand(0).getMBB()->getIterator() ||
+          Exit == MF.end())
+        report_fatal_error("Hardware loop is not laid out contiguously");
+
+      // LOOP_SETUP operands are the (reg, swizzle, mod) of the trip count.
+      BuildMI(*Preheader, *Setup, Setup->getDebugLoc(),
+              TII->get(MWV208::LOOP_s))
+          .add(Setup->getOperand(0))
+          .add(Setup->getOperand(1))
+          .add(Setup->getOperand(2))
+          .addMBB(&*Exit);
+      Setup->eraseFromParent();
+      // The exit is only reached by falling through the ENDLOOP, the printer
+      // would leave it without a label otherwise.
+      Exit->setMachineBlockAddressTaken();
+      Changed = true;
+    }
+  }
+
+  if (!Open.empty())
+    report_fatal_error("LOOP_SETUP without a matching ENDLOOP");
+  return Changed;
+}
+
+FunctionPass *llvm::createMwv208HardwareLoopsPass() {
+  return new Mwv208HardwareLoops();
+}
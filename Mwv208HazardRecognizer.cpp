@@ -0,0 +1,162 @@
+//===-- Mwv208HazardRecognizer.cpp - MWV208 hazard recognizer -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Read-after-write and write-after-write hazards on the temp registers and
+// a0, see Mwv208HazardRecognizer. Nops inserted to cover them are counted by
+// -stats under post-RA-hazard-rec.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Mwv208HazardRecognizer.h"
+#include "Mwv208InstrInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/CodeGen/MachineFunction.h"
+#include "llvm/CodeGen/ScheduleDAG.h"
+#include "llvm/CodeGen/TargetSubtargetInfo.h"
+#include "llvm/Support/ErrorHandling.h"
+using namespace llvm;
+
+Mwv208HazardRecognizer::Mwv208HazardRecognizer(const MachineFunction &MF)
+    : TRI(*MF.getSubtarget().getRegisterInfo()) {
+  const TargetSubtargetInfo &STI = MF.getSubtarget();
+  SchedModel.init(&STI);
+
+  // Nothing trails an instruction for longer than its latency. Samples are
+  // interlocked and do not count, see getWaitCycles.
+  const MCSchedModel &SM = *SchedModel.getMCSchedModel();
+  MaxLookAhead = 1;
+  for (unsigned SC = 0; SC != SM.NumSchedClasses; ++SC) {
+    const MCSchedClassDesc *Desc = SM.getSchedClassDesc(SC);
+    if (!Desc->isValid() || Desc->isVariant())
+      continue;
+    if (any_of(make_range(STI.getWriteProcResBegin(Desc),
+                          STI.getWriteProcResEnd(Desc)),
+               [&](const MCWriteProcResEntry &PRE) {
+                 return StringRef(SM.getProcResource(PRE.ProcResourceIdx)
+                                      ->Name) == "Mwv208UnitSampler";
+               }))
+      continue;
+    for (unsigned I = 0; I != Desc->NumWriteLatencyEntries; ++I) {
+      int Cycles = STI.getWriteLatencyEntry(Desc, I)->Cycles;
+      MaxLookAhead = std::max(MaxLookAhead, unsigned(std::max(Cycles, 0)));
+    }
+  }
+}
+
+// Components are sub-registers of their temp register, so a vec4 and a
+// scalar only conflict when the scalar's lane is one the vec4 writes.
+unsigned Mwv208HazardRecognizer::getWaitCycles(const MachineInstr &MI,
+                                               const MachineInstr &Prev,
+                                               unsigned Dist) const {
+  if (Mwv208InstrInfo::isSample(Prev))
+    return 0;
+  unsigned PrevLatency = SchedModel.computeInstrLatency(&Prev);
+  if (PrevLatency <= Dist)
+    return 0;
+
+  unsigned Wait = 0;
+  for (const MachineOperand &Def : Prev.all_defs()) {
+    Register Reg = Def.getReg();
+    if (!Reg)
+      continue;
+    // Sources are read at issue.
+    if (MI.readsRegister(Reg, &TRI)) {
+      Wait = std::max(Wait, PrevLatency - Dist);
+      continue;
+    }
+    // A shorter instruction must not complete first.
+    if (MI.modifiesRegister(Reg, &TRI)) {
+      unsigned Latency = SchedModel.computeInstrLatency(&MI);
+      if (Dist + Latency <= PrevLatency)
+        Wait = std::max(Wait, PrevLatency - Dist - Latency + 1);
+    }
+  }
+  return Wait;
+}
+
+unsigned Mwv208HazardRecognizer::getWaitCycles(
+    const MachineInstr &MI, const MachineBasicBlock &MBB,
+    MachineBasicBlock::const_reverse_instr_iterator I, unsigned Dist,
+    SmallPtrSetImpl<const MachineBasicBlock *> &Visited) const {
+  unsigned Wait = 0;
+  for (auto E = MBB.instr_rend(); I != E; ++I) {
+    if (I->isMetaInstruction() || I->isBundle())
+      continue;
+    if (++Dist > MaxLookAhead)
+      return Wait;
+    Wait = std::max(Wait, getWaitCycles(MI, *I, Dist));
+  }
+
+  // Every predecessor may be the one the block is entered from. Blocks are
+  // only skipped when they repeat on the same path, which only happens
+  // through blocks that do not issue anything.
+  for (const MachineBasicBlock *Pred : MBB.predecessors()) {
+    if (!Visited.insert(Pred).second)
+      continue;
+    Wait = std::max(Wait, getWaitCycles(MI, *Pred, Pred->instr_rbegin(), Dist,
+                                        Visited));
+    Visited.erase(Pred);
+  }
+  return Wait;
+}
+
+ScheduleHazardRecognizer::HazardType
+Mwv208HazardRecognizer::getHazardType(SUnit *SU, int Stalls) {
+  return PreEmitNoops(SU) ? NoopHazard : NoHazard;
+}
+
+// Scheduling only sees its region, the final count is left to
+// PreEmitNoops(MachineInstr *).
+unsigned Mwv208HazardRecognizer::PreEmitNoops(SUnit *SU) {
+  if (SU->isBoundaryNode())
+    return 0;
+  unsigned Wait = 0, Dist = 0;
+  for (const MachineInstr *Prev : EmittedInstrs) {
+    ++Dist;
+    if (Prev)
+      Wait = std::max(Wait, getWaitCycles(*SU->getInstr(), *Prev, Dist));
+  }
+  return Wait;
+}
+
+// The nops inserted for earlier instructions are in the block already, so
+// the block itself gives the distances.
+unsigned Mwv208HazardRecognizer::PreEmitNoops(MachineInstr *MI) {
+  if (MI->isMetaInstruction())
+    return 0;
+  const MachineInstr &CMI = *MI;
+  SmallPtrSet<const MachineBasicBlock *, 4> Visited;
+  return getWaitCycles(CMI, *CMI.getParent(),
+                       std::next(CMI.getReverseIterator()), 0, Visited);
+}
+
+void Mwv208HazardRecognizer::EmitInstruction(SUnit *SU) {
+  if (!SU->isBoundaryNode())
+    EmitInstruction(SU->getInstr());
+}
+
+void Mwv208HazardRecognizer::EmitInstruction(MachineInstr *MI) {
+  if (!MI->isMetaInstruction())
+    CurrCycleInstr = MI;
+}
+
+void Mwv208HazardRecognizer::AdvanceCycle() {
+  EmittedInstrs.push_front(CurrCycleInstr);
+  if (EmittedInstrs.size() > MaxLookAhead)
+    EmittedInstrs.pop_back();
+  CurrCycleInstr = nullptr;
+}
+
+void Mwv208HazardRecognizer::RecedeCycle() {
+  llvm_unreachable("MWV208 is only scheduled top-down after allocation");
+}
+
+void Mwv208HazardRecognizer::Reset() {
+  EmittedInstrs.clear();
+  CurrCycleInstr = nullptr;
+}
@@ -0,0 +1,77 @@
+//===-- Mwv208HazardRecognizer.h - MWV208 hazard recognizer -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The pipeline hazards of MWV208, which software has to cover with nops.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_MWV208_MWV208HAZARDRECOGNIZER_H
+#define LLVM_LIB_TARGET_MWV208_MWV208HAZARDRECOGNIZER_H
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/CodeGen/MachineBasicBlock.h"
+#include "llvm/CodeGen/ScheduleHazardRecognizer.h"
+#include "llvm/CodeGen/TargetSchedule.h"
+#include <deque>
+
+namespace llvm {
+
+class MachineFunction;
+class TargetRegisterInfo;
+
+/// The ALU pipelines do not interlock: an instruction issued before the
+/// result of an earlier one is written reads the old value, and one that
+/// completes first has its result overwritten. The number of cycles an
+/// instruction has to trail another is its latency in the scheduling model.
+/// Texture samples are the exception, their results are tracked by the
+/// sampler queue and reading them stalls in hardware.
+///
+/// The post-RA scheduler uses this to fill the wait with independent
+/// instructions; whatever wait is left is filled with nops by the
+/// PostRAHazardRecognizer pass, which measures it on the final code, across
+/// block boundaries.
+class Mwv208HazardRecognizer final : public ScheduleHazardRecognizer {
+  const TargetRegisterInfo &TRI;
+  TargetSchedModel SchedModel;
+
+  /// The instructions of the last MaxLookAhead cycles, most recent first,
+  /// nullptr for a cycle without one.
+  std::deque<const MachineInstr *> EmittedInstrs;
+  const MachineInstr *CurrCycleInstr = nullptr;
+
+  /// Cycles \p MI still has to wait when \p Prev issued \p Dist cycles
+  /// before it.
+  unsigned getWaitCycles(const MachineInstr &MI, const MachineInstr &Prev,
+                         unsigned Dist) const;
+  /// The same for the instructions before \p MI in \p MBB, and those at the
+  /// end of its predecessors, up to MaxLookAhead cycles back.
+  unsigned getWaitCycles(const MachineInstr &MI, const MachineBasicBlock &MBB,
+                         MachineBasicBlock::const_reverse_instr_iterator I,
+                         unsigned Dist,
+                         SmallPtrSetImpl<const MachineBasicBlock *> &Visited)
+      const;
+
+public:
+  explicit Mwv208HazardRecognizer(const MachineFunction &MF);
+
+  HazardType getHazardType(SUnit *SU, int Stalls) override;
+  unsigned PreEmitNoops(SUnit *SU) override;
+  unsigned PreEmitNoops(MachineInstr *MI) override;
+  void EmitInstruction(SUnit *SU) override;
+  void EmitInstruction(MachineInstr *MI) override;
+  void AdvanceCycle() override;
+  void RecedeCycle() override;
+  void Reset() override;
+
+  /// One instruction issues per cycle.
+  bool atIssueLimit() const override { return CurrCycleInstr; }
+};
+
+} // end namespace llvm
+
+#endif // LLVM_LIB_TARGET_MWV208_MWV208HAZARDRECOGNIZER_H
@@ -11,15 +11,30 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "MCTargetDesc/Mwv208BaseInfo.h"
+#include "Mwv208MachineFunctionInfo.h"
 #include "Mwv208TargetMachine.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
 #include "llvm/CodeGen/SelectionDAGISel.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
 using namespace llvm;
 
+#define GET_INSTRINFO_OPERAND_TYPE
+#include "Mwv208GenInstrInfo.inc"
+
 #define DEBUG_TYPE "mwv208-isel"
 #define PASS_NAME "MWV208 DAG->DAG Pattern Instruction Selection"
 
+STATISTIC(NumNegFolded, "Number of source operands with a NEG modifier");
+STATISTIC(NumAbsFolded, "Number of source operands with an ABS modifier");
+STATISTIC(NumSatFolded, "Number of clamps folded into a SATURATE bit");
+STATISTIC(NumConstOperands, "Number of source operands read from the "
+                            "constant bank");
+STATISTIC(NumImmOperands, "Number of source operands encoded as immediates");
+
 //===----------------------------------------------------------------------===//
 // Instruction Selector Implementation
 //===----------------------------------------------------------------------===//
@@ -34,6 +49,13 @@ class Mwv208DAGToDAGISel : public SelectionDAGISel {
   /// make the right decision when generating code for different targets.
   const Mwv208Subtarget *Subtarget = nullptr;
 
+  /// Number of selected source operands of the current function with a NEG
+  /// or ABS modifier.
+  unsigned NumModsFolded = 0;
+
+  /// Uniforms and literals of the current function.
+  Mwv208ConstantBank *Bank = nullptr;
+
 public:
   Mwv208DAGToDAGISel() = delete;
 
@@ -41,15 +63,54 @@ public:
 
   bool runOnMachineFunction(MachineFunction &MF) override {
     Subtarget = &MF.getSubtarget<Mwv208Subtarget>();
-    return SelectionDAGISel::runOnMachineFunction(MF);
+    Bank = &MF.getInfo<Mwv208MachineFunctionInfo>()->getConstantBank();
+    NumModsFolded = 0;
+    bool Changed = SelectionDAGISel::runOnMachineFunction(MF);
+    LLVM_DEBUG(dbgs() << "MWV208 ISel: folded " << NumModsFolded
+                      << " source modifiers in " << MF.getName() << '\n');
+    return Changed;
   }
 
   void Select(SDNode *N) override;
+  void PostprocessISelDAG() override;
+
+  /// SelectSrc - Match a source operand as (reg, swizzle, mod), folding
+  /// permutes, splats and element extracts into the swizzle.
+  bool SelectSrc(SDValue N, SDValue &Reg, SDValue &Swz, SDValue &Mod) {
+    return selectSrcOperand(N, Reg, Swz, Mod, /*AllowMods=*/false);
+  }
+
+  /// SelectSrcMods - Like SelectSrc, and also fold fneg/fabs into the NEG and
+  /// ABS modifier bits. Only used by floating point instructions.
+  bool SelectSrcMods(SDValue N, SDValue &Reg, SDValue &Swz, SDValue &Mod) {
+    return selectSrcOperand(N, Reg, Swz, Mod, /*AllowMods=*/true);
+  }
+
+  /// SelectImmI/SelectImmF - Match an integer or f32 constant, or a splat of
+  /// one, that fits the immediate form of a source operand.
+  bool SelectImmI(SDValue N, SDValue &Imm) {
+    return selectImm(N, Imm, MWV208::SrcImm::S20);
+  }
+  bool SelectImmF(SDValue N, SDValue &Imm) {
+    return selectImm(N, Imm, MWV208::SrcImm::F20);
+  }
 
   // Include the pieces autogenerated from the target description.
 #include "Mwv208GenDAGISel.inc"
 
 private:
+  bool selectSrcOperand(SDValue N, SDValue &Reg, SDValue &Swz, SDValue &Mod,
+                        bool AllowMods);
+  bool selectImm(SDValue N, SDValue &Imm, MWV208::SrcImm::Kind Kind);
+  MCRegister getConstRegister(Mwv208ConstantBank::Slot S, bool IsScalar,
+                              unsigned &Swizzle) const;
+  const Constant *getLiteral(SDValue N) const;
+  bool finalizeSrcOperands(SDNode *N);
+  bool trySelectImmMove(SDNode *N);
+  bool trySelectSrcMove(SDNode *N);
+  void selectInsertVectorElt(SDNode *N);
+  void selectBuildVector(SDNode *N);
+  bool foldSaturateMove(SDNode *N);
 };
 
 class Mwv208DAGToDAGISelLegacy : public SelectionDAGISelLegacy {
@@ -64,6 +125,322 @@ char Mwv208DAGToDAGISelLegacy::ID = 0;
 
 INITIALIZE_PASS(Mwv208DAGToDAGISelLegacy, DEBUG_TYPE, PASS_NAME, false, false)
 
+// A swizzle can only describe values made of four 32-bit lanes, or a scalar
+// living in the x lane of a temp register.
+static bool isSwizzleableType(EVT VT) {
+  if (VT.isVector())
+    return VT.getVectorNumElements() == 4 &&
+           VT.getScalarSizeInBits() == 32;
+  return VT.getSizeInBits() == 32;
+}
+
+/// Look through the swizzle-like nodes that produce \p N. \p Swz is the
+/// swizzle the consumer applies to \p N. On return \p N is the value that is
+/// really read and \p Swz the composed swizzle. Scalars always live in the x
+/// lane, so reading one is the swizzle .xxxx.
+static void foldSwizzle(SDValue &N, unsigned &Swz) {
+  using namespace MWV208;
+
+  while (isSwizzleableType(N.getValueType())) {
+    switch (N.getOpcode()) {
+    default:
+      return;
+
+    case ISD::BITCAST: {
+      // A swizzle does not care about the lane type.
+      SDValue In = N.getOperand(0);
+      if (!isSwizzleableType(In.getValueType()) ||
+          In.getValueType().isVector() != N.getValueType().isVector())
+        return;
+      N = In;
+      break;
+    }
+
+    case ISD::VECTOR_SHUFFLE: {
+      auto *SVN = cast<ShuffleVectorSDNode>(N);
+      ArrayRef<int> Mask = SVN->getMask();
+      // Every lane has to come from the same input.
+      int Input = -1;
+      unsigned NewSwz = 0;
+      for (unsigned Lane = 0; Lane != 4; ++Lane) {
+        int Elt = Mask[Swizzle::getComponent(Swz, Lane)];
+        if (Elt < 0)
+          continue;
+        if (Input >= 0 && Input != Elt / 4)
+          return;
+        Input = Elt / 4;
+        NewSwz = Swizzle::setComponent(NewSwz, Lane, Elt % 4);
+      }
+      if (Input < 0)
+        return;
+      N = N.getOperand(Input);
+      Swz = NewSwz;
+      break;
+    }
+
+    case ISD::EXTRACT_VECTOR_ELT: {
+      auto *Idx = dyn_cast<ConstantSDNode>(N.getOperand(1));
+      SDValue Vec = N.getOperand(0);
+      if (!Idx || !isSwizzleableType(Vec.getValueType()))
+        return;
+      N = Vec;
+      Swz = Swizzle::splat(Idx->getZExtValue());
+      break;
+    }
+
+    case ISD::SCALAR_TO_VECTOR:
+      // Only the x lane is defined.
+      N = N.getOperand(0);
+      Swz = Swizzle::XXXX;
+      break;
+
+    case ISD::BUILD_VECTOR: {
+      // Either a splat of one scalar, or a permute of the lanes of one vector
+      // spelled out as element extracts.
+      SDValue Splat, Vec;
+      unsigned NewSwz = 0;
+      bool IsSplat = true, IsPermute = true;
+      for (unsigned Lane = 0; Lane != 4; ++Lane) {
+        SDValue Elt = N.getOperand(Swizzle::getComponent(Swz, Lane));
+        if (Elt.isUndef())
+          continue;
+        if (Splat && Splat != Elt)
+          IsSplat = false;
+        Splat = Elt;
+
+        auto *Idx = Elt.getOpcode() == ISD::EXTRACT_VECTOR_ELT
+                        ? dyn_cast<ConstantSDNode>(Elt.getOperand(1))
+                        : nullptr;
+        if (!Idx || (Vec && Vec != Elt.getOperand(0)) ||
+            !isSwizzleableType(Elt.getOperand(0).getValueType())) {
+          IsPermute = false;
+          continue;
+        }
+        Vec = Elt.getOperand(0);
+        NewSwz = Swizzle::setComponent(NewSwz, Lane, Idx->getZExtValue());
+      }
+      if (!Splat)
+        return;
+      if (IsSplat) {
+        N = Splat;
+        Swz = Swizzle::XXXX;
+      } else if (IsPermute) {
+        N = Vec;
+        Swz = NewSwz;
+      } else {
+        return;
+      }
+      break;
+    }
+    }
+  }
+}
+
+bool Mwv208DAGToDAGISel::selectSrcOperand(SDValue N, SDValue &Reg,
+                                          SDValue &Swz, SDValue &Mod,
+                                          bool AllowMods) {
+  SDLoc DL(N);
+  EVT VT = N.getValueType();
+  unsigned Swizzle =
+      VT.isVector() ? MWV208::Swizzle::XYZW : MWV208::Swizzle::XXXX;
+  unsigned Mods = 0;
+
+  // The modifiers act on each lane, so they commute with the swizzle. The
+  // hardware applies ABS first, then NEG: a negate found below an abs is
+  // dropped, one found above it toggles NEG.
+  for (;;) {
+    foldSwizzle(N, Swizzle);
+    if (!AllowMods)
+      break;
+
+    if (N.getOpcode() == ISD::FNEG) {
+      if (!(Mods & MWV208::SrcMod::ABS))
+        Mods ^= MWV208::SrcMod::NEG;
+    } else if (N.getOpcode() == ISD::FABS) {
+      Mods |= MWV208::SrcMod::ABS;
+    } else {
+      break;
+    }
+    N = N.getOperand(0);
+  }
+
+  // Uniforms and literals are read straight from their c register. The
+  // matcher calls this for patterns that may still fail, so literals are
+  // only given a place in the bank once the instruction reading them is
+  // selected, see finalizeSrcOperands. Until then the operand is a constant
+  // pool entry holding the bits.
+  if (N.getOpcode() == MWV208ISD::CONST_REG) {
+    Mwv208ConstantBank::Slot S{unsigned(N.getConstantOperandVal(0)),
+                               unsigned(N.getConstantOperandVal(1))};
+    Reg = CurDAG->getRegister(getConstRegister(S, !VT.isVector(), Swizzle),
+                              VT);
+    Swz = CurDAG->getTargetConstant(Swizzle, DL, MVT::i8);
+    Mod = CurDAG->getTargetConstant(Mods, DL, MVT::i8);
+    return true;
+  }
+  if (const Constant *C = getLiteral(N)) {
+    Reg = CurDAG->getTargetConstantPool(C, VT);
+    Swz = CurDAG->getTargetConstant(Swizzle, DL, MVT::i8);
+    Mod = CurDAG->getTargetConstant(Mods, DL, MVT::i8);
+    return true;
+  }
+
+  // Scalars live in component registers, vectors in whole registers. A
+  // scalar operand read from a vector lane is that lane's component, which
+  // costs nothing once the sub-register copy is coalesced. A vector operand
+  // splatting a scalar reads it from lane x of an otherwise undefined vector.
+  if (!VT.isVector() && N.getValueType().isVector()) {
+    unsigned Lane = MWV208::Swizzle::getComponent(Swizzle, 0);
+    N = CurDAG->getTargetExtractSubreg(MWV208::getComponentSubReg(Lane), DL,
+                                       VT, N);
+    Swizzle = MWV208::Swizzle::XXXX;
+  } else if (VT.isVector() && !N.getValueType().isVector()) {
+    MVT VecVT = N.getValueType().isFloatingPoint() ? MVT::v4f32 : MVT::v4i32;
+    SDValue Undef(
+        CurDAG->getMachineNode(TargetOpcode::IMPLICIT_DEF, DL, VecVT), 0);
+    N = CurDAG->getTargetInsertSubreg(MWV208::subx, DL, VecVT, Undef, N);
+  }
+
+  Reg = N;
+  Swz = CurDAG->getTargetConstant(Swizzle, DL, MVT::i8);
+  Mod = CurDAG->getTargetConstant(Mods, DL, MVT::i8);
+  return true;
+}
+
+/// The immediate operand holds the full 32-bit value, the encoder keeps the
+/// bits that matter. Undefined lanes of a splat take the splatted value.
+bool Mwv208DAGToDAGISel::selectImm(SDValue N, SDValue &Imm,
+                                   MWV208::SrcImm::Kind Kind) {
+  uint32_t Bits;
+  if (Kind == MWV208::SrcImm::F20) {
+    ConstantFPSDNode *C = isConstOrConstSplatFP(N, /*AllowUndefs=*/true);
+    if (!C || C->getValueType(0).getScalarType() != MVT::f32)
+      return false;
+    Bits = C->getValueAPF().bitcastToAPInt().getZExtValue();
+  } else {
+    ConstantSDNode *C = isConstOrConstSplat(N, /*AllowUndefs=*/true);
+    if (!C)
+      return false;
+    Bits = C->getAPIntValue().trunc(32).getZExtValue();
+  }
+  if (!MWV208::SrcImm::isEncodable(Kind, Bits))
+    return false;
+
+  Imm = CurDAG->getTargetConstant(Bits, SDLoc(N), MVT::i32);
+  return true;
+}
+
+/// The c register, or its component for a scalar operand, holding the value
+/// at \p S. \p Swizzle is the one the consumer applies to the value and
+/// becomes the one to apply to the register.
+MCRegister Mwv208DAGToDAGISel::getConstRegister(Mwv208ConstantBank::Slot S,
+                                                bool IsScalar,
+                                                unsigned &Swizzle) const {
+  MCRegister CReg = MWV208::ConstRegClassRegClass.getRegister(S.Reg);
+  Swizzle = MWV208::Swizzle::compose(S.Swizzle, Swizzle);
+  if (IsScalar) {
+    unsigned Lane = MWV208::Swizzle::getComponent(Swizzle, 0);
+    CReg = Subtarget->getRegisterInfo()->getSubReg(
+        CReg, MWV208::getComponentSubReg(Lane));
+    Swizzle = MWV208::Swizzle::XXXX;
+  }
+  return CReg;
+}
+
+/// The bits of \p N as an i32 or <4 x i32> constant if it is a literal
+/// scalar or vec4, undefined lanes staying undef.
+const Constant *Mwv208DAGToDAGISel::getLiteral(SDValue N) const {
+  auto getBits = [](SDValue V) -> std::optional<uint32_t> {
+    if (auto *C = dyn_cast<ConstantSDNode>(V))
+      return uint32_t(C->getZExtValue());
+    if (auto *C = dyn_cast<ConstantFPSDNode>(V))
+      return uint32_t(C->getValueAPF().bitcastToAPInt().getZExtValue());
+    return std::nullopt;
+  };
+
+  if (!isSwizzleableType(N.getValueType()))
+    return nullptr;
+  Type *I32 = Type::getInt32Ty(*CurDAG->getContext());
+  if (N.getOpcode() != ISD::BUILD_VECTOR) {
+    std::optional<uint32_t> Bits = getBits(N);
+    return Bits ? ConstantInt::get(I32, *Bits) : nullptr;
+  }
+
+  SmallVector<Constant *, 4> Lanes;
+  for (SDValue Elt : N->op_values()) {
+    std::optional<uint32_t> Bits = getBits(Elt);
+    if (!Elt.isUndef() && !Bits)
+      return nullptr;
+    Lanes.push_back(Bits ? ConstantInt::get(I32, *Bits) : UndefValue::get(I32));
+  }
+  return ConstantVector::get(Lanes);
+}
+
+/// The operands of an always-true predicate, see Mwv208Pred.
+static void addUnpredicated(SelectionDAG &DAG, const SDLoc &DL,
+                            SmallVectorImpl<SDValue> &Ops) {
+  Ops.push_back(DAG.getTargetConstant(MWV208::COND_TRUE, DL, MVT::i32));
+  Ops.push_back(DAG.getRegister(MWV208::NoRegister, MVT::i32));
+}
+
+/// A constant no user could fold is materialized from an immediate when it
+/// fits one, which keeps it out of the constant bank.
+bool Mwv208DAGToDAGISel::trySelectImmMove(SDNode *N) {
+  SDValue V(N, 0);
+  EVT VT = V.getValueType();
+  if (!isSwizzleableType(VT))
+    return false;
+
+  SDValue Imm;
+  bool IsFP = VT.isFloatingPoint();
+  if (!selectImm(V, Imm, IsFP ? MWV208::SrcImm::F20 : MWV208::SrcImm::S20))
+    return false;
+
+  SDLoc DL(N);
+  SDValue Sat = CurDAG->getTargetConstant(0, DL, MVT::i1);
+  unsigned Opc = IsFP ? (VT.isVector() ? MWV208::MOV_i : MWV208::MOV_i_s)
+                      : (VT.isVector() ? MWV208::MOVI_i : MWV208::MOVI_i_s);
+  SmallVector<SDValue, 4> Ops = {Imm, Sat};
+  addUnpredicated(*CurDAG, DL, Ops);
+  ReplaceNode(N, CurDAG->getMachineNode(Opc, DL, VT, Ops));
+  return true;
+}
+
+/// A permute, splat, extract, bitcast, fneg or fabs whose users could not
+/// absorb it into their own source operand becomes a single MOV with that
+/// swizzle and those modifiers, or a plain copy when there is nothing left to
+/// apply.
+bool Mwv208DAGToDAGISel::trySelectSrcMove(SDNode *N) {
+  SDValue Reg, Swz, Mod;
+  SDValue V(N, 0);
+  EVT VT = V.getValueType();
+  if (!isSwizzleableType(VT) ||
+      !selectSrcOperand(V, Reg, Swz, Mod, VT.isFloatingPoint()) || Reg == V)
+    return false;
+
+  SDLoc DL(N);
+  unsigned Identity =
+      VT.isVector() ? MWV208::Swizzle::XYZW : MWV208::Swizzle::XXXX;
+  // c registers are not allocatable, copying one out takes a mov.
+  if (cast<ConstantSDNode>(Swz)->getZExtValue() == Identity &&
+      cast<ConstantSDNode>(Mod)->isZero() && !isa<RegisterSDNode>(Reg) &&
+      !isa<ConstantPoolSDNode>(Reg)) {
+    unsigned RCID = VT.isVector() ? MWV208::TempRegClassRegClassID
+                                  : MWV208::Component32RegClassID;
+    ReplaceNode(N, CurDAG->getMachineNode(
+                       TargetOpcode::COPY_TO_REGCLASS, DL, VT, Reg,
+                       CurDAG->getTargetConstant(RCID, DL, MVT::i32)));
+    return true;
+  }
+
+  SDValue Sat = CurDAG->getTargetConstant(0, DL, MVT::i1);
+  unsigned Opc = VT.isVector() ? MWV208::MOV : MWV208::MOV_s;
+  SmallVector<SDValue, 6> Ops = {Reg, Swz, Mod, Sat};
+  addUnpredicated(*CurDAG, DL, Ops);
+  ReplaceNode(N, CurDAG->getMachineNode(Opc, DL, VT, Ops));
+  return true;
+}
+
 void Mwv208DAGToDAGISel::Select(SDNode *N) {
   SDLoc dl(N);
   if (N->isMachineOpcode()) {
@@ -74,14 +451,201 @@ void Mwv208DAGToDAGISel::Select(SDNode *N) {
   switch (N->getOpcode()) {
   default:
     break;
-  case ISD::ADD:
-    // TODO
+  case ISD::Constant:
+  case ISD::ConstantFP:
+    if (trySelectImmMove(N))
+      return;
+    [[fallthrough]];
+  case ISD::VECTOR_SHUFFLE:
+  case ISD::EXTRACT_VECTOR_ELT:
+  case ISD::SCALAR_TO_VECTOR:
+  case ISD::FNEG:
+  case ISD::FABS:
+  case ISD::BITCAST:
+  case MWV208ISD::CONST_REG:
+    if (trySelectSrcMove(N))
+      return;
     break;
+  case ISD::BUILD_VECTOR:
+    if (!trySelectImmMove(N) && !trySelectSrcMove(N))
+      selectBuildVector(N);
+    return;
+  case ISD::INSERT_VECTOR_ELT:
+    // Variable lanes are expanded during legalization.
+    selectInsertVectorElt(N);
+    return;
   }
 
   SelectCode(N);
 }
 
+/// An insert at a constant lane is a write of that component only: the
+/// producer of the element ends up writing the lane through its destination
+/// write mask, the rest of the vector stays live in place.
+void Mwv208DAGToDAGISel::selectInsertVectorElt(SDNode *N) {
+  unsigned Lane = N->getConstantOperandVal(2);
+  SDValue Ins = CurDAG->getTargetInsertSubreg(
+      MWV208::getComponentSubReg(Lane), SDLoc(N), N->getValueType(0),
+      N->getOperand(0), N->getOperand(1));
+  ReplaceNode(N, Ins.getNode());
+}
+
+/// A vector assembled from unrelated scalars becomes a REG_SEQUENCE, so each
+/// scalar is written straight into its lane.
+void Mwv208DAGToDAGISel::selectBuildVector(SDNode *N) {
+  SDLoc DL(N);
+  SmallVector<SDValue, 9> Ops;
+  Ops.push_back(
+      CurDAG->getTargetConstant(MWV208::TempRegClassRegClassID, DL, MVT::i32));
+  for (unsigned Lane = 0; Lane != 4; ++Lane) {
+    SDValue Elt = N->getOperand(Lane);
+    // Lanes left undefined are simply never written.
+    if (Elt.isUndef())
+      continue;
+    Ops.push_back(Elt);
+    Ops.push_back(CurDAG->getTargetConstant(MWV208::getComponentSubReg(Lane),
+                                            DL, MVT::i32));
+  }
+  if (Ops.size() == 1) {
+    ReplaceNode(N, CurDAG->getMachineNode(TargetOpcode::IMPLICIT_DEF, DL,
+                                          N->getValueType(0)));
+    return;
+  }
+  ReplaceNode(N, CurDAG->getMachineNode(TargetOpcode::REG_SEQUENCE, DL,
+                                        N->getValueType(0), Ops));
+}
+
+/// A clamp is first selected as mov.sat. When the mov neither swizzles nor
+/// modifies its source and is the only user of it, set the SATURATE bit of
+/// the producing instruction instead and drop the mov.
+bool Mwv208DAGToDAGISel::foldSaturateMove(SDNode *N) {
+  // MOV inputs are (src, swizzle, mod, sat, pred cc, pred reg).
+  if (!N->isMachineOpcode() ||
+      (N->getMachineOpcode() != MWV208::MOV &&
+       N->getMachineOpcode() != MWV208::MOV_s) ||
+      !N->getConstantOperandVal(3))
+    return false;
+
+  SDValue Src = N->getOperand(0);
+  unsigned Identity = Src.getValueType().isVector() ? MWV208::Swizzle::XYZW
+                                                    : MWV208::Swizzle::XXXX;
+  if (N->getConstantOperandVal(1) != Identity ||
+      N->getConstantOperandVal(2) != 0 ||
+      Src.getValueType() != N->getValueType(0))
+    return false;
+
+  SDNode *Def = Src.getNode();
+  if (!Def->isMachineOpcode() || !Src.hasOneUse())
+    return false;
+
+  const MCInstrDesc &Desc = TII->get(Def->getMachineOpcode());
+  if (!(Desc.TSFlags & MWV208II::HasSaturate))
+    return false;
+
+  SDLoc DL(Def);
+  SmallVector<SDValue, 8> Ops(Def->op_begin(), Def->op_end());
+  // $sat is the last input, or comes right before the two predicate inputs.
+  unsigned SatIdx = Desc.getNumOperands() - Desc.getNumDefs() - 1;
+  if (Desc.isPredicable())
+    SatIdx -= 2;
+  Ops[SatIdx] = CurDAG->getTargetConstant(1, DL, MVT::i1);
+  SDNode *NewDef = CurDAG->getMachineNode(Def->getMachineOpcode(), DL,
+                                          Def->getVTList(), Ops);
+  ReplaceUses(SDValue(N, 0), SDValue(NewDef, 0));
+  ++NumSatFolded;
+  return true;
+}
+
+/// Give the literals read by the selected instruction \p N their place in
+/// the constant bank, and count its source operands.
+bool Mwv208DAGToDAGISel::finalizeSrcOperands(SDNode *N) {
+  using namespace MWV208;
+
+  unsigned Opc = N->getMachineOpcode();
+  const MCInstrDesc &Desc = TII->get(Opc);
+  SmallVector<SDValue, 8> Ops(N->op_begin(), N->op_end());
+  bool Changed = false;
+  // Machine node operands are the instruction's inputs, then chain and glue.
+  for (unsigned I = 0, E = Ops.size();
+       I != E && I + Desc.getNumDefs() < Desc.getNumOperands(); ++I) {
+    int Ty = getOperandType(Opc, I + Desc.getNumDefs());
+    if (Ty == OpTypes::SrcImmI || Ty == OpTypes::SrcImmF) {
+      ++NumImmOperands;
+      continue;
+    }
+    if (Ty != OpTypes::SrcRegClass && Ty != OpTypes::SrcComp32)
+      continue;
+
+    // (reg, swizzle, mod), see Mwv208SrcOperand.
+    if (auto *CP = dyn_cast<ConstantPoolSDNode>(Ops[I])) {
+      const Constant *C = CP->getConstVal();
+      SmallVector<std::optional<uint32_t>, 4> Lanes;
+      for (unsigned L = 0, LE = C->getType()->isVectorTy() ? 4 : 1; L != LE;
+           ++L) {
+        const Constant *Elt = LE == 1 ? C : C->getAggregateElement(L);
+        if (auto *CI = dyn_cast<ConstantInt>(Elt))
+          Lanes.push_back(uint32_t(CI->getZExtValue()));
+        else
+          Lanes.push_back(std::nullopt);
+      }
+      std::optional<Mwv208ConstantBank::Slot> S = Bank->addLiterals(Lanes);
+      if (!S)
+        report_fatal_error("Literals do not fit in the constant bank");
+
+      SDLoc DL(N);
+      unsigned Swizzle = cast<ConstantSDNode>(Ops[I + 1])->getZExtValue();
+      EVT VT = Ops[I].getValueType();
+      Ops[I] = CurDAG->getRegister(
+          getConstRegister(*S, Ty == OpTypes::SrcComp32, Swizzle), VT);
+      Ops[I + 1] = CurDAG->getTargetConstant(Swizzle, DL, MVT::i8);
+      Changed = true;
+    }
+
+    if (auto *R = dyn_cast<RegisterSDNode>(Ops[I]))
+      if (ConstRegClassRegClass.contains(R->getReg()) ||
+          Const32RegClass.contains(R->getReg()))
+        ++NumConstOperands;
+    // The matcher may fold the same fneg/fabs for patterns that then fail,
+    // so modifiers are counted on what was selected.
+    unsigned Mods = cast<ConstantSDNode>(Ops[I + 2])->getZExtValue();
+    if (Mods & SrcMod::NEG)
+      ++NumNegFolded;
+    if (Mods & SrcMod::ABS)
+      ++NumAbsFolded;
+    if (Mods & (SrcMod::NEG | SrcMod::ABS))
+      ++NumModsFolded;
+    I += 2;
+  }
+
+  if (!Changed)
+    return false;
+  SDNode *New = CurDAG->UpdateNodeOperands(N, Ops);
+  if (New != N)
+    ReplaceUses(N, New);
+  return true;
+}
+
+void Mwv208DAGToDAGISel::PostprocessISelDAG() {
+  bool MadeChange = false;
+  for (SDNode &N : CurDAG->allnodes())
+    MadeChange |= foldSaturateMove(&N);
+
+  if (MadeChange)
+    CurDAG->RemoveDeadNodes();
+
+  // Only the instructions left now are emitted.
+  SmallVector<SDNode *, 32> Selected;
+  for (SDNode &N : CurDAG->allnodes())
+    if (N.isMachineOpcode())
+      Selected.push_back(&N);
+  MadeChange = false;
+  for (SDNode *N : Selected)
+    MadeChange |= finalizeSrcOperands(N);
+
+  if (MadeChange)
+    CurDAG->RemoveDeadNodes();
+}
+
 /// createMwv208ISelDag - This pass converts a legalized DAG into a
 /// MWV208-specific DAG, ready for instruction scheduling.
 ///
@@ -13,15 +13,20 @@
 //===----------------------------------------------------------------------===//
 
 #include "Mwv208ISelLowering.h"
+#include "MCTargetDesc/Mwv208BaseInfo.h"
 #include "MCTargetDesc/Mwv208MCExpr.h"
 #include "MCTargetDesc/Mwv208MCTargetDesc.h"
 #include "Mwv208MachineFunctionInfo.h"
 #include "Mwv208RegisterInfo.h"
 #include "Mwv208TargetMachine.h"
 #include "Mwv208TargetObjectFile.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/StringSwitch.h"
+#include "llvm/Analysis/UniformityAnalysis.h"
 #include "llvm/CodeGen/CallingConvLower.h"
+#include "llvm/CodeGen/FunctionLoweringInfo.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/CodeGen/MachineInstrBuilder.h"
@@ -32,14 +37,30 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/KnownBits.h"
+#include "llvm/Support/MathExtras.h"
 using namespace llvm;
 
 #define DEBUG_TYPE "mwv208-isellowering"
 #define DEBUG
 
+STATISTIC(NumDotProducts, "Number of DP3/DP4 formed from fadd/fma chains");
+STATISTIC(NumDotReductions, "Number of DP4 formed from fadd reductions");
+STATISTIC(NumHardwareLoops, "Number of loop latches lowered to ENDLOOP");
+STATISTIC(NumPrivateAccesses,
+          "Number of private array accesses kept in registers");
+STATISTIC(NumPrivateDynamic,
+          "Number of private array accesses indexed through a0");
+STATISTIC(NumSamples, "Number of texture builtins lowered");
+STATISTIC(NumScalarSamples,
+          "Number of texture samples writing a single component");
+STATISTIC(NumUniformAccesses, "Number of uniform array reads from c registers");
+STATISTIC(NumUniformDynamic,
+          "Number of uniform array reads indexed through a0");
+
 //===----------------------------------------------------------------------===//
 // Calling Convention Implementation
 //===----------------------------------------------------------------------===//
@@ -49,39 +70,14 @@ using namespace llvm;
 Register
 Mwv208TargetLowering::getRegisterByName(const char *RegName, LLT VT,
                                         const MachineFunction &MF) const {
+  // r0 ... rN, bounded by the register file of the subtarget.
+  StringRef Name(RegName);
+  unsigned Idx;
+  if (Name.consume_front("r") && !Name.getAsInteger(10, Idx) &&
+      Idx < MF.getSubtarget<Mwv208Subtarget>().getNumTempRegs())
+    return MWV208::TempRegClassRegClass.getRegister(Idx);
+
   Register Reg = StringSwitch<Register>(RegName)
-                     .Case("r0", MWV208::r0)
-                     .Case("r1", MWV208::r1)
-                     .Case("r2", MWV208::r2)
-                     .Case("r3", MWV208::r3)
-                     .Case("r4", MWV208::r4)
-                     .Case("r5", MWV208::r5)
-                     .Case("r6", MWV208::r6)
-                     .Case("r7", MWV208::r7)
-                     .Case("r8", MWV208::r8)
-                     .Case("r9", MWV208::r9)
-                     .Case("r10", MWV208::r10)
-                     .Case("r11", MWV208::r11)
-                     .Case("r12", MWV208::r12)
-                     .Case("r13", MWV208::r13)
-                     .Case("r14", MWV208::r14)
-                     .Case("r15", MWV208::r15)
-                     .Case("r16", MWV208::r16)
-                     .Case("r17", MWV208::r17)
-                     .Case("r18", MWV208::r18)
-                     .Case("r19", MWV208::r19)
-                     .Case("r20", MWV208::r20)
-                     .Case("r21", MWV208::r21)
-                     .Case("r22", MWV208::r22)
-                     .Case("r23", MWV208::r23)
-                     .Case("r24", MWV208::r24)
-                     .Case("r25", MWV208::r25)
-                     .Case("r26", MWV208::r26)
-                     .Case("r27", MWV208::r27)
-                     .Case("r28", MWV208::r28)
-                     .Case("r29", MWV208::r29)
-                     .Case("r30", MWV208::r30)
-                     .Case("r31", MWV208::r31)
                      .Case("c0", MWV208::c0)
                      .Case("c1", MWV208::c1)
                      .Case("c2", MWV208::c2)
@@ -104,12 +100,916 @@ Mwv208TargetLowering::getRegisterByName(const char *RegName, LLT VT,
 
 Mwv208TargetLowering::Mwv208TargetLowering(const TargetMachine &TM,
                                            const Mwv208Subtarget &STI)
-    : TargetLowering(TM), Subtarget(&STI) {}
+    : TargetLowering(TM), Subtarget(&STI) {
+  // Every temp register holds four 32-bit components. Vectors use the whole
+  // register, scalars a single component, so four scalars share a register.
+  addRegisterClass(MVT::v4i32, &MWV208::TempRegClassRegClass);
+  addRegisterClass(MVT::v4f32, &MWV208::TempRegClassRegClass);
+  addRegisterClass(MVT::i32, &MWV208::Component32RegClass);
+  addRegisterClass(MVT::f32, &MWV208::Component32RegClass);
+
+  computeRegisterProperties(STI.getRegisterInfo());
+
+  // Permutes, splats and lane extracts are free: the selector folds them into
+  // the swizzle of the consuming source operand. A shuffle of two vectors is
+  // not a swizzle, see LowerOperation.
+  for (MVT VT : {MVT::v4i32, MVT::v4f32}) {
+    setOperationAction(ISD::VECTOR_SHUFFLE, VT, Custom);
+    setOperationAction(ISD::SCALAR_TO_VECTOR, VT, Legal);
+    setOperationAction(ISD::BUILD_VECTOR, VT, Legal);
+    // Inserts at a constant lane are partial writes through the destination
+    // write mask. A variable lane goes through a lane mask, see
+    // LowerOperation.
+    setOperationAction(ISD::INSERT_VECTOR_ELT, VT, Custom);
+    setOperationAction(ISD::EXTRACT_VECTOR_ELT, VT, Custom);
+  }
+
+  // There is no memory to spill to: stack objects are arrays held in temp
+  // registers, see LowerLOAD.
+  for (MVT VT : {MVT::i32, MVT::f32, MVT::v4i32, MVT::v4f32}) {
+    setOperationAction(ISD::LOAD, VT, Custom);
+    setOperationAction(ISD::STORE, VT, Custom);
+  }
+
+  // Literals live in the constant bank, see Mwv208DAGToDAGISel.
+  setOperationAction(ISD::ConstantFP, MVT::f32, Legal);
+
+  // fneg and fabs are source modifiers of every floating point instruction.
+  for (MVT VT : {MVT::f32, MVT::v4f32}) {
+    setOperationAction(ISD::FNEG, VT, Legal);
+    setOperationAction(ISD::FABS, VT, Legal);
+    // mad.f32 does not round the product.
+    setOperationAction(ISD::FMA, VT, Legal);
+  }
+
+  // Saturating adds and subtracts are plain ones with the SATURATE bit set.
+  for (MVT VT : {MVT::i32, MVT::v4i32}) {
+    setOperationAction(ISD::SADDSAT, VT, Legal);
+    setOperationAction(ISD::UADDSAT, VT, Legal);
+    setOperationAction(ISD::SSUBSAT, VT, Legal);
+    setOperationAction(ISD::USUBSAT, VT, Legal);
+    setOperationAction({ISD::SMIN, ISD::SMAX, ISD::UMIN, ISD::UMAX}, VT,
+                       Legal);
+    setOperationAction({ISD::AND, ISD::OR, ISD::XOR, ISD::SHL, ISD::SRA,
+                        ISD::SRL},
+                       VT, Legal);
+  }
+
+  for (MVT VT : {MVT::f32, MVT::v4f32}) {
+    setOperationAction({ISD::FMINNUM, ISD::FMAXNUM}, VT, Legal);
+    // a - b is a + -b, the negate being a NEG source modifier.
+    setOperationAction(ISD::FSUB, VT, Expand);
+    // set.f32 only knows ordered compares and an unordered NE.
+    setCondCodeAction({ISD::SETO, ISD::SETUO, ISD::SETONE, ISD::SETUEQ,
+                       ISD::SETUGT, ISD::SETUGE, ISD::SETULT, ISD::SETULE},
+                      VT, Expand);
+  }
+
+  // set writes all ones to the lanes where the condition holds.
+  setBooleanContents(ZeroOrNegativeOneBooleanContent);
+  setBooleanVectorContents(ZeroOrNegativeOneBooleanContent);
+
+  // branch and sel test a value against zero, so a setcc against zero folds
+  // into them and any other one stays a separate set.
+  for (MVT VT : {MVT::i32, MVT::f32, MVT::v4i32, MVT::v4f32}) {
+    setOperationAction(ISD::BR_CC, VT, Expand);
+    setOperationAction(ISD::SELECT_CC, VT, Expand);
+  }
+  // sel picks per lane, a scalar condition is splatted first.
+  for (MVT VT : {MVT::v4i32, MVT::v4f32}) {
+    setOperationAction(ISD::SELECT, VT, Custom);
+    setOperationAction(ISD::VSELECT, VT, Legal);
+  }
+
+  // clamp(x, 0.0, 1.0) is the SATURATE bit of the instruction producing x.
+  setTargetDAGCombine(
+      {ISD::FMINNUM, ISD::FMAXNUM, ISD::FMINNUM_IEEE, ISD::FMAXNUM_IEEE});
+  // Sums of three or four products are dot products.
+  setTargetDAGCombine({ISD::FADD, ISD::FMA, ISD::VECREDUCE_FADD});
+  // Hardware loop latches, see Mwv208TTIImpl::isHardwareLoopProfitable.
+  setTargetDAGCombine(ISD::BRCOND);
+  // Texel swizzles and texels of a single used lane, see
+  // performSampleSwizzleCombine.
+  setTargetDAGCombine({ISD::EXTRACT_VECTOR_ELT, ISD::VECTOR_SHUFFLE});
+}
 
 bool Mwv208TargetLowering::useSoftFloat() const { return false; }
 
+EVT Mwv208TargetLowering::getSetCCResultType(const DataLayout &DL,
+                                             LLVMContext &Context,
+                                             EVT VT) const {
+  if (!VT.isVector())
+    return MVT::i32;
+  return VT.changeVectorElementTypeToInteger();
+}
+
+bool Mwv208TargetLowering::isFPImmLegal(const APFloat &Imm, EVT VT,
+                                        bool ForCodeSize) const {
+  return VT == MVT::f32;
+}
+
+/// Return true if every defined lane of \p Mask reads the same input.
+static bool isSwizzleMask(ArrayRef<int> Mask) {
+  int Input = -1;
+  for (int Elt : Mask) {
+    if (Elt < 0)
+      continue;
+    if (Input >= 0 && Input != Elt / 4)
+      return false;
+    Input = Elt / 4;
+  }
+  return true;
+}
+
+bool Mwv208TargetLowering::isShuffleMaskLegal(ArrayRef<int> Mask,
+                                              EVT VT) const {
+  return isSwizzleMask(Mask);
+}
+
+// Kernel arguments are uniforms: the driver writes them into the constant
+// bank, in front of the literals, and every use reads them from there.
+SDValue Mwv208TargetLowering::LowerFormalArguments(
+    SDValue Chain, CallingConv::ID CallConv, bool IsVarArg,
+    const SmallVectorImpl<ISD::InputArg> &Ins, const SDLoc &DL,
+    SelectionDAG &DAG, SmallVectorImpl<SDValue> &InVals) const {
+  MachineFunction &MF = DAG.getMachineFunction();
+  Mwv208ConstantBank &Bank =
+      MF.getInfo<Mwv208MachineFunctionInfo>()->getConstantBank();
+
+  for (const ISD::InputArg &In : Ins) {
+    MVT VT = In.VT;
+    // Arrays passed byref are uniform arrays, placed whole, see
+    // lowerUniformLoad.
+    if (In.Flags.isByRef()) {
+      unsigned Size = In.Flags.getByRefSize();
+      std::optional<unsigned> First =
+          Bank.addUniformArray(In.getOrigArgIndex(), Size);
+      if (!First)
+        report_fatal_error("Kernel arguments do not fit in the constant bank");
+      InVals.push_back(DAG.getNode(MWV208ISD::UNIFORM_ARRAY, DL, VT,
+                                   DAG.getTargetConstant(*First, DL, MVT::i32),
+                                   DAG.getTargetConstant(Size, DL, MVT::i32)));
+      continue;
+    }
+
+    if (VT != MVT::i32 && VT != MVT::f32 && VT != MVT::v4i32 &&
+        VT != MVT::v4f32)
+      report_fatal_error("Unsupported kernel argument type");
+
+    unsigned ArgSize = In.ArgVT.getStoreSize().getFixedValue();
+    std::optional<Mwv208ConstantBank::Slot> S =
+        Bank.addUniform(In.getOrigArgIndex(), In.PartOffset, ArgSize,
+                        VT.isVector() ? 4 : 1);
+    if (!S)
+      report_fatal_error("Kernel arguments do not fit in the constant bank");
+
+    InVals.push_back(DAG.getNode(
+        MWV208ISD::CONST_REG, DL, VT,
+        DAG.getTargetConstant(S->Reg, DL, MVT::i32),
+        DAG.getTargetConstant(S->Swizzle, DL, MVT::i8)));
+  }
+  return Chain;
+}
+
+namespace {
+/// A texture builtin and the node it becomes.
+struct SampleBuiltin {
+  StringLiteral Name;
+  unsigned Opc;
+  unsigned NumArgs;
+};
+} // end anonymous namespace
+
+static const SampleBuiltin SampleBuiltins[] = {
+    {"__mwv208_sample", MWV208ISD::SAMPLE, 2},
+    {"__mwv208_sample_lod", MWV208ISD::SAMPLE_LOD, 3},
+    {"__mwv208_sample_bias", MWV208ISD::SAMPLE_BIAS, 3},
+    {"__mwv208_gather", MWV208ISD::GATHER, 3},
+    {"__mwv208_fetch", MWV208ISD::FETCH, 3},
+};
+
+// Kernels are fully inlined, so the only calls left are to the texture
+// builtins, which are declared as
+//   T __mwv208_sample(i32 sampler, <4 x float> coord)
+//   T __mwv208_sample_lod(i32 sampler, <4 x float> coord, float lod)
+//   T __mwv208_sample_bias(i32 sampler, <4 x float> coord, float bias)
+//   T __mwv208_gather(i32 sampler, <4 x float> coord, i32 component)
+//   T __mwv208_fetch(i32 sampler, <4 x i32> coord, i32 lod)
+// T being <4 x float> or <4 x i32> depending on the texture format. The
+// sampler and the gathered component must be constants.
+SDValue Mwv208TargetLowering::LowerCall(CallLoweringInfo &CLI,
+                                        SmallVectorImpl<SDValue> &InVals) const {
+  SelectionDAG &DAG = CLI.DAG;
+  const SDLoc &DL = CLI.DL;
+  StringRef Name;
+  if (auto *G = dyn_cast<GlobalAddressSDNode>(CLI.Callee))
+    Name = G->getGlobal()->getName();
+  else if (auto *E = dyn_cast<ExternalSymbolSDNode>(CLI.Callee))
+    Name = E->getSymbol();
+
+  const SampleBuiltin *B = find_if(
+      SampleBuiltins, [&](const SampleBuiltin &B) { return B.Name == Name; });
+  if (B == std::end(SampleBuiltins))
+    report_fatal_error("Function calls are unsupported");
+
+  bool IsFetch = B->Opc == MWV208ISD::FETCH;
+  EVT CoordVT = IsFetch ? MVT::v4i32 : MVT::v4f32;
+  EVT ArgVT = IsFetch || B->Opc == MWV208ISD::GATHER ? MVT::i32 : MVT::f32;
+  auto *Sampler = CLI.OutVals.empty()
+                      ? nullptr
+                      : dyn_cast<ConstantSDNode>(CLI.OutVals[0]);
+  if (CLI.IsVarArg || CLI.OutVals.size() != B->NumArgs ||
+      CLI.Ins.size() != 1 ||
+      (CLI.Ins[0].VT != MVT::v4f32 && CLI.Ins[0].VT != MVT::v4i32) ||
+      CLI.OutVals[1].getValueType() != CoordVT ||
+      (B->NumArgs == 3 && CLI.OutVals[2].getValueType() != ArgVT))
+    report_fatal_error(Twine("Invalid call to ") + Name);
+  if (!Sampler || Sampler->getZExtValue() > 31)
+    report_fatal_error(Twine("The sampler of ") + Name +
+                       " must be a constant from 0 to 31");
+
+  SmallVector<SDValue, 4> Ops = {CLI.OutVals[1]};
+  if (B->Opc == MWV208ISD::GATHER) {
+    auto *Comp = dyn_cast<ConstantSDNode>(CLI.OutVals[2]);
+    if (!Comp || Comp->getZExtValue() > 3)
+      report_fatal_error(Twine("The component of ") + Name +
+                         " must be a constant from 0 to 3");
+    Ops.push_back(DAG.getTargetConstant(Comp->getZExtValue(), DL, MVT::i32));
+  } else if (B->NumArgs == 3) {
+    Ops.push_back(CLI.OutVals[2]);
+  }
+  Ops.push_back(DAG.getTargetConstant(Sampler->getZExtValue(), DL, MVT::i32));
+  Ops.push_back(DAG.getTargetConstant(MWV208::Swizzle::XYZW, DL, MVT::i8));
+
+  CLI.IsTailCall = false;
+  InVals.push_back(DAG.getNode(B->Opc, DL, CLI.Ins[0].VT, Ops));
+  ++NumSamples;
+  return CLI.Chain;
+}
+
+bool Mwv208TargetLowering::isFMAFasterThanFMulAndFAdd(const MachineFunction &MF,
+                                                      EVT VT) const {
+  // mad.f32 issues like a single add or mul.
+  return VT.getScalarType() == MVT::f32;
+}
+
+/// All ones in lane \p Idx of a v4i32, zero in the others.
+static SDValue getLaneMask(SDValue Idx, const SDLoc &DL, SelectionDAG &DAG) {
+  SmallVector<SDValue, 4> Lanes;
+  for (unsigned I = 0; I != 4; ++I)
+    Lanes.push_back(DAG.getConstant(I, DL, MVT::i32));
+  SDValue Splat = DAG.getSplatBuildVector(
+      MVT::v4i32, DL, DAG.getZExtOrTrunc(Idx, DL, MVT::i32));
+  return DAG.getSetCC(DL, MVT::v4i32, Splat,
+                      DAG.getBuildVector(MVT::v4i32, DL, Lanes), ISD::SETEQ);
+}
+
+/// Return true if \p V is the start of an array: a stack object or a uniform
+/// array argument.
+static bool isArrayBase(SDValue V) {
+  return isa<FrameIndexSDNode>(V) || V.getOpcode() == MWV208ISD::UNIFORM_ARRAY;
+}
+
+/// Split the address of an array access into its base, see isArrayBase, a
+/// constant byte offset and at most one variable byte offset.
+static bool matchArrayAddress(SDValue Ptr, SDValue &Base, int64_t &Offset,
+                              SDValue &Index) {
+  if (isArrayBase(Ptr)) {
+    Base = Ptr;
+    return true;
+  }
+  if (Ptr.getOpcode() != ISD::ADD &&
+      !(Ptr.getOpcode() == ISD::OR && Ptr->getFlags().hasDisjoint()))
+    return false;
+
+  for (unsigned I = 0; I != 2; ++I) {
+    SDValue Term = Ptr.getOperand(1 - I);
+    int64_t TermOffset = Offset;
+    SDValue TermIndex = Index;
+    if (auto *C = dyn_cast<ConstantSDNode>(Term))
+      TermOffset += C->getSExtValue();
+    else if (!TermIndex)
+      TermIndex = Term;
+    else
+      continue;
+    if (matchArrayAddress(Ptr.getOperand(I), Base, TermOffset, TermIndex)) {
+      Offset = TermOffset;
+      Index = TermIndex;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// Turn the byte offset \p ByteIdx into an index of \p EltBytes elements.
+/// GEPs usually scale the index right before adding it, in which case the
+/// scale is simply dropped. Constant terms of the index, as in a[i + 1], are
+/// added to \p Elt, so that they end up in the register number.
+static SDValue getElementIndex(SDValue ByteIdx, unsigned EltBytes,
+                               int64_t &Elt, const SDLoc &DL,
+                               SelectionDAG &DAG) {
+  unsigned Shift = Log2_32(EltBytes);
+  unsigned Opc = ByteIdx.getOpcode();
+  SDValue Idx;
+  if ((Opc == ISD::SHL || Opc == ISD::MUL) &&
+      isa<ConstantSDNode>(ByteIdx.getOperand(1)) &&
+      ByteIdx.getConstantOperandVal(1) == (Opc == ISD::SHL ? Shift : EltBytes)) {
+    Idx = DAG.getZExtOrTrunc(ByteIdx.getOperand(0), DL, MVT::i32);
+  } else {
+    if (DAG.computeKnownBits(ByteIdx).countMinTrailingZeros() < Shift)
+      report_fatal_error("Misaligned array access");
+    Idx = DAG.getNode(ISD::SRL, DL, MVT::i32,
+                      DAG.getZExtOrTrunc(ByteIdx, DL, MVT::i32),
+                      DAG.getConstant(Shift, DL, MVT::i32));
+  }
+
+  while (Idx.getOpcode() == ISD::ADD &&
+         isa<ConstantSDNode>(Idx.getOperand(1))) {
+    Elt += cast<ConstantSDNode>(Idx.getOperand(1))->getSExtValue();
+    Idx = Idx.getOperand(0);
+  }
+  return Idx;
+}
+
+/// The register operand of a relative access to element \p Elt of an array
+/// of \p NumElts registers starting at register \p First, \p Idx elements
+/// further. The constant part goes into the register number when that still
+/// names a register of the array, into the index otherwise: the register
+/// is an operand of the access, one outside the array would look read or
+/// written.
+static SDValue getRelativeReg(unsigned First, int64_t Elt, SDValue &Idx,
+                              unsigned NumElts, const SDLoc &DL,
+                              SelectionDAG &DAG) {
+  int64_t Reg = First + Elt;
+  if (Elt < 0 || Elt >= NumElts) {
+    Idx = DAG.getNode(ISD::ADD, DL, MVT::i32, Idx,
+                      DAG.getConstant(Elt, DL, MVT::i32));
+    Reg = First;
+  }
+  return DAG.getTargetConstant(Reg, DL, MVT::i32);
+}
+
+namespace {
+/// Operands of PRIVATE_LOAD/PRIVATE_STORE for one access, or none when a
+/// constant index falls outside the array.
+struct PrivateAccess {
+  bool InBounds = false;
+  SDValue Reg, First, Size, Index;
+};
+} // end anonymous namespace
+
+/// Map a load or store of stack object \p FI onto the temp registers holding
+/// it.
+static PrivateAccess lowerPrivateAddress(MemSDNode *N, SDValue Base,
+                                         int64_t Offset, SDValue ByteIdx,
+                                         SelectionDAG &DAG,
+                                         unsigned NumTempRegs) {
+  SDLoc DL(N);
+  EVT VT = N->getMemoryVT();
+  int FI = cast<FrameIndexSDNode>(Base)->getIndex();
+
+  MachineFunction &MF = DAG.getMachineFunction();
+  unsigned EltBytes = VT.getStoreSize();
+  std::optional<Mwv208PrivateArray> A =
+      MF.getInfo<Mwv208MachineFunctionInfo>()->getPrivateArray(
+          FI, MF.getFrameInfo().getObjectSize(FI), EltBytes, NumTempRegs);
+  if (!A)
+    report_fatal_error("Private array does not fit in the temp registers or "
+                       "is accessed with several element sizes");
+  if (Offset % EltBytes)
+    report_fatal_error("Misaligned array access");
+
+  PrivateAccess P;
+  int64_t Elt = Offset / EltBytes;
+  if (!ByteIdx && (Elt < 0 || Elt >= A->NumElts))
+    return P;
+
+  P.InBounds = true;
+  P.First = DAG.getTargetConstant(A->Base, DL, MVT::i32);
+  P.Size = DAG.getTargetConstant(A->NumElts, DL, MVT::i32);
+  if (ByteIdx) {
+    P.Index = getElementIndex(ByteIdx, EltBytes, Elt, DL, DAG);
+    P.Reg = getRelativeReg(A->Base, Elt, P.Index, A->NumElts, DL, DAG);
+    ++NumPrivateDynamic;
+  } else {
+    P.Index = DAG.getTargetConstant(0, DL, MVT::i32);
+    P.Reg = DAG.getTargetConstant(A->Base + Elt, DL, MVT::i32);
+  }
+  ++NumPrivateAccesses;
+  return P;
+}
+
+/// Lane \p Idx of \p Vec, a variable lane. Relative addressing offsets whole
+/// registers, not lanes, so the lane is masked out and the lanes are or'ed
+/// together.
+static SDValue lowerVariableExtract(SDValue Vec, SDValue Idx, EVT VT,
+                                    const SDLoc &DL, SelectionDAG &DAG) {
+  SDValue V = DAG.getNode(ISD::AND, DL, MVT::v4i32,
+                          DAG.getBitcast(MVT::v4i32, Vec),
+                          getLaneMask(Idx, DL, DAG));
+  V = DAG.getNode(ISD::OR, DL, MVT::v4i32, V,
+                  DAG.getVectorShuffle(MVT::v4i32, DL, V,
+                                       DAG.getUNDEF(MVT::v4i32),
+                                       {2, 3, -1, -1}));
+  V = DAG.getNode(ISD::OR, DL, MVT::v4i32, V,
+                  DAG.getVectorShuffle(MVT::v4i32, DL, V,
+                                       DAG.getUNDEF(MVT::v4i32),
+                                       {1, -1, -1, -1}));
+  V = DAG.getNode(ISD::EXTRACT_VECTOR_ELT, DL, MVT::i32, V,
+                  DAG.getVectorIdxConstant(0, DL));
+  return DAG.getBitcast(VT, V);
+}
+
+/// Uniform arrays fill whole c registers with their bytes in order, see
+/// LowerFormalArguments. A constant index is a plain uniform operand, a
+/// variable one reads the register through a0, see CONST_LOAD.
+static SDValue lowerUniformLoad(LoadSDNode *LD, SDValue Base, int64_t Offset,
+                                SDValue ByteIdx, SelectionDAG &DAG) {
+  SDLoc DL(LD);
+  EVT VT = LD->getValueType(0);
+  unsigned First = Base.getConstantOperandVal(0);
+  unsigned Size = Base.getConstantOperandVal(1);
+  unsigned EltBytes = VT.getStoreSize();
+  if (Offset % EltBytes)
+    report_fatal_error("Misaligned array access");
+
+  SDValue V;
+  if (!ByteIdx) {
+    if (Offset < 0 || Offset + EltBytes > Size)
+      return DAG.getMergeValues({DAG.getUNDEF(VT), LD->getChain()}, DL);
+    unsigned Lane = Offset % 16 / 4;
+    V = DAG.getNode(
+        MWV208ISD::CONST_REG, DL, VT,
+        DAG.getTargetConstant(First + Offset / 16, DL, MVT::i32),
+        DAG.getTargetConstant(VT.isVector() ? MWV208::Swizzle::XYZW
+                                            : MWV208::Swizzle::splat(Lane),
+                              DL, MVT::i8));
+  } else if (DAG.computeKnownBits(ByteIdx).countMinTrailingZeros() >= 4) {
+    // The index steps whole registers, the lane is known.
+    int64_t Elt = divideFloorSigned(Offset, 16);
+    unsigned Lane = (Offset - Elt * 16) / 4;
+    SDValue Idx = getElementIndex(ByteIdx, 16, Elt, DL, DAG);
+    SDValue Reg =
+        getRelativeReg(First, Elt, Idx, divideCeil(Size, 16), DL, DAG);
+    if (!VT.isVector())
+      Reg = DAG.getTargetConstant(
+          cast<ConstantSDNode>(Reg)->getZExtValue() * 4 + Lane, DL, MVT::i32);
+    V = DAG.getNode(MWV208ISD::CONST_LOAD, DL, VT, Reg, Idx);
+    ++NumUniformDynamic;
+  } else {
+    // A packed scalar array: read the register holding the element, then
+    // pick its lane.
+    if (VT.isVector() ||
+        DAG.computeKnownBits(ByteIdx).countMinTrailingZeros() < 2)
+      report_fatal_error("Misaligned array access");
+    SDValue Bytes = DAG.getNode(ISD::ADD, DL, MVT::i32,
+                                DAG.getZExtOrTrunc(ByteIdx, DL, MVT::i32),
+                                DAG.getConstant(Offset, DL, MVT::i32));
+    SDValue Idx = DAG.getNode(ISD::SRL, DL, MVT::i32, Bytes,
+                              DAG.getConstant(4, DL, MVT::i32));
+    SDValue Lane = DAG.getNode(
+        ISD::AND, DL, MVT::i32,
+        DAG.getNode(ISD::SRL, DL, MVT::i32, Bytes,
+                    DAG.getConstant(2, DL, MVT::i32)),
+        DAG.getConstant(3, DL, MVT::i32));
+    EVT VecVT = EVT::getVectorVT(*DAG.getContext(), VT, 4);
+    SDValue Vec = DAG.getNode(MWV208ISD::CONST_LOAD, DL, VecVT,
+                              DAG.getTargetConstant(First, DL, MVT::i32), Idx);
+    V = lowerVariableExtract(Vec, Lane, VT, DL, DAG);
+    ++NumUniformDynamic;
+  }
+  ++NumUniformAccesses;
+  return DAG.getMergeValues({V, LD->getChain()}, DL);
+}
+
+// Stack objects are small arrays in the private address space. Rather than
+// spilling them to memory they stay in temp registers, one element per
+// register, and a dynamic index is applied through the relative addressing
+// of mov, see PRIV_LOAD. Uniform arrays are read from the constant bank the
+// same way.
+SDValue Mwv208TargetLowering::LowerLOAD(SDValue Op, SelectionDAG &DAG) const {
+  LoadSDNode *LD = cast<LoadSDNode>(Op);
+  if (LD->getExtensionType() != ISD::NON_EXTLOAD ||
+      LD->getMemoryVT() != LD->getValueType(0))
+    report_fatal_error("Extending loads from arrays are unsupported");
+
+  SDValue Base, ByteIdx;
+  int64_t Offset = 0;
+  if (!matchArrayAddress(LD->getBasePtr(), Base, Offset, ByteIdx))
+    report_fatal_error("Load is not from a private or uniform array");
+  if (Base.getOpcode() == MWV208ISD::UNIFORM_ARRAY)
+    return lowerUniformLoad(LD, Base, Offset, ByteIdx, DAG);
+
+  SDLoc DL(Op);
+  EVT VT = Op.getValueType();
+  PrivateAccess P = lowerPrivateAddress(LD, Base, Offset, ByteIdx, DAG,
+                                        Subtarget->getNumTempRegs());
+  if (!P.InBounds)
+    return DAG.getMergeValues({DAG.getUNDEF(VT), LD->getChain()}, DL);
+
+  SDVTList VTs = DAG.getVTList(VT, MVT::Other);
+  SDValue Ops[] = {LD->getChain(), P.Reg, P.First, P.Size, P.Index};
+  SDValue Load = DAG.getMemIntrinsicNode(MWV208ISD::PRIVATE_LOAD, DL, VTs, Ops,
+                                         LD->getMemoryVT(),
+                                         LD->getMemOperand());
+  return DAG.getMergeValues({Load, Load.getValue(1)}, DL);
+}
+
+SDValue Mwv208TargetLowering::LowerSTORE(SDValue Op, SelectionDAG &DAG) const {
+  StoreSDNode *ST = cast<StoreSDNode>(Op);
+  if (ST->isTruncatingStore())
+    report_fatal_error("Truncating stores to arrays are unsupported");
+
+  SDValue Base, ByteIdx;
+  int64_t Offset = 0;
+  if (!matchArrayAddress(ST->getBasePtr(), Base, Offset, ByteIdx) ||
+      Base.getOpcode() == MWV208ISD::UNIFORM_ARRAY)
+    report_fatal_error("Store is not to a private array");
+
+  SDLoc DL(Op);
+  PrivateAccess P = lowerPrivateAddress(ST, Base, Offset, ByteIdx, DAG,
+                                        Subtarget->getNumTempRegs());
+  if (!P.InBounds)
+    return ST->getChain();
+
+  SDValue Ops[] = {ST->getChain(), ST->getValue(), P.Reg, P.First, P.Size,
+                   P.Index};
+  return DAG.getMemIntrinsicNode(MWV208ISD::PRIVATE_STORE, DL,
+                                 DAG.getVTList(MVT::Other), Ops,
+                                 ST->getMemoryVT(), ST->getMemOperand());
+}
+
+SDValue Mwv208TargetLowering::LowerOperation(SDValue Op,
+                                             SelectionDAG &DAG) const {
+  switch (Op.getOpcode()) {
+  default:
+    llvm_unreachable("Should not custom lower this!");
+  case ISD::LOAD:
+    return LowerLOAD(Op, DAG);
+  case ISD::STORE:
+    return LowerSTORE(Op, DAG);
+  case ISD::INSERT_VECTOR_ELT: {
+    // Keep constant lanes for the selector. Relative addressing offsets
+    // whole registers, not lanes, so a variable lane selects the new value
+    // into the lane whose number matches.
+    if (isa<ConstantSDNode>(Op.getOperand(2)))
+      return Op;
+    SDLoc DL(Op);
+    EVT VT = Op.getValueType();
+    return DAG.getNode(ISD::VSELECT, DL, VT,
+                       getLaneMask(Op.getOperand(2), DL, DAG),
+                       DAG.getSplatBuildVector(VT, DL, Op.getOperand(1)),
+                       Op.getOperand(0));
+  }
+  case ISD::VECTOR_SHUFFLE: {
+    // Keep swizzles for the selector. Lanes from both inputs are a sel
+    // between a swizzle of each, picked by a constant lane mask.
+    ArrayRef<int> Mask = cast<ShuffleVectorSDNode>(Op)->getMask();
+    if (isSwizzleMask(Mask))
+      return Op;
+    SDLoc DL(Op);
+    EVT VT = Op.getValueType();
+    SmallVector<int, 4> Mask0, Mask1;
+    SmallVector<SDValue, 4> Cond;
+    for (int Elt : Mask) {
+      bool FromOp1 = Elt >= 4;
+      Mask0.push_back(FromOp1 ? -1 : Elt);
+      Mask1.push_back(FromOp1 ? Elt - 4 : -1);
+      Cond.push_back(FromOp1 ? DAG.getAllOnesConstant(DL, MVT::i32)
+                             : DAG.getConstant(0, DL, MVT::i32));
+    }
+    SDValue Undef = DAG.getUNDEF(VT);
+    return DAG.getNode(
+        ISD::VSELECT, DL, VT, DAG.getBuildVector(MVT::v4i32, DL, Cond),
+        DAG.getVectorShuffle(VT, DL, Op.getOperand(1), Undef, Mask1),
+        DAG.getVectorShuffle(VT, DL, Op.getOperand(0), Undef, Mask0));
+  }
+  case ISD::EXTRACT_VECTOR_ELT:
+    // A constant lane is a swizzle.
+    if (isa<ConstantSDNode>(Op.getOperand(1)))
+      return Op;
+    return lowerVariableExtract(Op.getOperand(0), Op.getOperand(1),
+                                Op.getValueType(), SDLoc(Op), DAG);
+  case ISD::SELECT: {
+    SDLoc DL(Op);
+    EVT VT = Op.getValueType();
+    SDValue Mask = DAG.getSplatBuildVector(
+        VT.changeVectorElementTypeToInteger(), DL, Op.getOperand(0));
+    return DAG.getNode(ISD::VSELECT, DL, VT, Mask, Op.getOperand(1),
+                       Op.getOperand(2));
+  }
+  }
+}
+
 const char *Mwv208TargetLowering::getTargetNodeName(unsigned Opcode) const {
-  return "todo";
+  switch ((MWV208ISD::NodeType)Opcode) {
+  case MWV208ISD::FIRST_NUMBER:
+    break;
+  case MWV208ISD::CLAMP:
+    return "MWV208ISD::CLAMP";
+  case MWV208ISD::DP3:
+    return "MWV208ISD::DP3";
+  case MWV208ISD::DP4:
+    return "MWV208ISD::DP4";
+  case MWV208ISD::CONST_REG:
+    return "MWV208ISD::CONST_REG";
+  case MWV208ISD::LOOP_END:
+    return "MWV208ISD::LOOP_END";
+  case MWV208ISD::UNIFORM_ARRAY:
+    return "MWV208ISD::UNIFORM_ARRAY";
+  case MWV208ISD::CONST_LOAD:
+    return "MWV208ISD::CONST_LOAD";
+  case MWV208ISD::SAMPLE:
+    return "MWV208ISD::SAMPLE";
+  case MWV208ISD::SAMPLE_LOD:
+    return "MWV208ISD::SAMPLE_LOD";
+  case MWV208ISD::SAMPLE_BIAS:
+    return "MWV208ISD::SAMPLE_BIAS";
+  case MWV208ISD::GATHER:
+    return "MWV208ISD::GATHER";
+  case MWV208ISD::FETCH:
+    return "MWV208ISD::FETCH";
+  case MWV208ISD::PRIVATE_LOAD:
+    return "MWV208ISD::PRIVATE_LOAD";
+  case MWV208ISD::PRIVATE_STORE:
+    return "MWV208ISD::PRIVATE_STORE";
+  }
+  return nullptr;
+}
+
+// fminimum/fmaximum propagate NaN, which the saturate bit does not, so only
+// the minnum/maxnum flavours form a clamp.
+static bool isFMinOpcode(unsigned Opc) {
+  return Opc == ISD::FMINNUM || Opc == ISD::FMINNUM_IEEE;
+}
+
+static bool isFMaxOpcode(unsigned Opc) {
+  return Opc == ISD::FMAXNUM || Opc == ISD::FMAXNUM_IEEE;
+}
+
+static bool isConstFPValue(SDValue V, double Val) {
+  ConstantFPSDNode *C = isConstOrConstSplatFP(V);
+  return C && C->isExactlyValue(Val);
+}
+
+/// Match min(max(x, 0.0), 1.0) and max(min(x, 1.0), 0.0), in any operand
+/// order, and return x.
+static SDValue matchClampToUnit(SDNode *N) {
+  unsigned Opc = N->getOpcode();
+  bool OuterIsMin = isFMinOpcode(Opc);
+  if (!OuterIsMin && !isFMaxOpcode(Opc))
+    return SDValue();
+
+  double OuterBound = OuterIsMin ? 1.0 : 0.0;
+  double InnerBound = OuterIsMin ? 0.0 : 1.0;
+  for (unsigned I = 0; I != 2; ++I) {
+    SDValue Inner = N->getOperand(I);
+    if (!isConstFPValue(N->getOperand(1 - I), OuterBound) ||
+        !(OuterIsMin ? isFMaxOpcode(Inner.getOpcode())
+                     : isFMinOpcode(Inner.getOpcode())))
+      continue;
+    for (unsigned J = 0; J != 2; ++J)
+      if (isConstFPValue(Inner.getOperand(1 - J), InnerBound))
+        return Inner.getOperand(J);
+  }
+  return SDValue();
+}
+
+using DotTerm = std::pair<SDValue, SDValue>;
+
+/// Return true if the fadd/fmul/fma \p V may be fused into a dot product,
+/// which rounds once.
+static bool canFuseIntoDot(SDValue V, const TargetOptions &Opts) {
+  return V->getFlags().hasAllowContract() ||
+         Opts.AllowFPOpFusion == FPOpFusion::Fast || Opts.UnsafeFPMath;
+}
+
+/// Collect the products summed by the fadd/fma tree rooted at \p V. Inner
+/// nodes must have a single use so that nothing is computed twice.
+static bool collectDotTerms(SDValue V, bool IsRoot, const TargetOptions &Opts,
+                            SmallVectorImpl<DotTerm> &Terms) {
+  if (Terms.size() >= 4 || (!IsRoot && !V.hasOneUse()))
+    return false;
+
+  switch (V.getOpcode()) {
+  case ISD::FADD:
+    return canFuseIntoDot(V, Opts) &&
+           collectDotTerms(V.getOperand(0), false, Opts, Terms) &&
+           collectDotTerms(V.getOperand(1), false, Opts, Terms);
+  case ISD::FMA:
+    // An explicit fma rounds its own result, which a dot product drops.
+    if (!canFuseIntoDot(V, Opts))
+      return false;
+    Terms.emplace_back(V.getOperand(0), V.getOperand(1));
+    return collectDotTerms(V.getOperand(2), false, Opts, Terms);
+  case ISD::FMUL:
+    if (!canFuseIntoDot(V, Opts))
+      return false;
+    Terms.emplace_back(V.getOperand(0), V.getOperand(1));
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Return true if a DP3/DP4 can be formed at \p V.
+static bool formsDot(SDValue V, const TargetOptions &Opts) {
+  SmallVector<DotTerm, 4> Terms;
+  return collectDotTerms(V, true, Opts, Terms) && Terms.size() >= 3;
+}
+
+/// Return true if \p N is summed into a larger tree by its only user, and
+/// that tree forms a dot product itself. Otherwise, say with a bias added
+/// or a fifth term, the dot product is formed at \p N and the rest stays
+/// an fadd.
+static bool isInnerDotNode(SDNode *N, const TargetOptions &Opts) {
+  if (!N->hasOneUse())
+    return false;
+  SDNode *User = *N->user_begin();
+  bool IsSummed =
+      User->getOpcode() == ISD::FADD ||
+      (User->getOpcode() == ISD::FMA && User->getOperand(2).getNode() == N);
+  return IsSummed && formsDot(SDValue(User, 0), Opts);
+}
+
+/// a0*b0 + a1*b1 + a2*b2 [+ a3*b3], written with fadd, fmul and fma in any
+/// association, becomes DP3/DP4 of (a0, a1, a2, a3) and (b0, b1, b2, b3).
+/// When the ai and bi are lanes of two vectors the build_vectors fold back
+/// into those vectors and their swizzles.
+static SDValue performDotCombine(SDNode *N, SelectionDAG &DAG) {
+  const TargetOptions &Opts = DAG.getTarget().Options;
+  if (N->getValueType(0) != MVT::f32 || isInnerDotNode(N, Opts))
+    return SDValue();
+
+  SmallVector<DotTerm, 4> Terms;
+  if (!collectDotTerms(SDValue(N, 0), true, Opts, Terms) || Terms.size() < 3)
+    return SDValue();
+
+  SDLoc DL(N);
+  SmallVector<SDValue, 4> A, B;
+  for (const DotTerm &T : Terms) {
+    A.push_back(T.first);
+    B.push_back(T.second);
+  }
+  unsigned Opc = MWV208ISD::DP4;
+  if (Terms.size() == 3) {
+    Opc = MWV208ISD::DP3;
+    A.push_back(DAG.getUNDEF(MVT::f32));
+    B.push_back(DAG.getUNDEF(MVT::f32));
+  }
+  ++NumDotProducts;
+  return DAG.getNode(Opc, DL, MVT::f32, DAG.getBuildVector(MVT::v4f32, DL, A),
+                     DAG.getBuildVector(MVT::v4f32, DL, B));
+}
+
+/// vector.reduce.fadd(fmul(a, b)) is DP4(a, b). Only the reassociable form
+/// reaches the DAG as VECREDUCE_FADD, see Mwv208TTIImpl.
+static SDValue performReduceFAddCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue Vec = N->getOperand(0);
+  if (Vec.getValueType() != MVT::v4f32 || Vec.getOpcode() != ISD::FMUL ||
+      !Vec.hasOneUse())
+    return SDValue();
+  // reassoc on the reduction says nothing about rounding the products.
+  if (!canFuseIntoDot(Vec, DAG.getTarget().Options))
+    return SDValue();
+
+  ++NumDotReductions;
+  return DAG.getNode(MWV208ISD::DP4, SDLoc(N), MVT::f32, Vec.getOperand(0),
+                     Vec.getOperand(1));
+}
+
+/// HardwareLoops ends the latch with brcond (loop.decrement 1), Header. That
+/// is a single ENDLOOP, which keeps the counter in the loop stack, so the
+/// decrement itself goes away. When the exit is the branch target instead
+/// the condition is negated, and the brcond and the br that follows it
+/// trade destinations.
+static SDValue performBrCondCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue Cond = N->getOperand(1);
+  SDValue Dest = N->getOperand(2);
+
+  bool Negated = false;
+  if (Cond.getOpcode() == ISD::XOR && isOneConstant(Cond.getOperand(1))) {
+    Negated = true;
+    Cond = Cond.getOperand(0);
+  }
+  if (Cond.getOpcode() != ISD::INTRINSIC_W_CHAIN ||
+      Cond.getConstantOperandVal(1) != Intrinsic::loop_decrement)
+    return SDValue();
+
+  if (Negated) {
+    SDNode *Br = nullptr;
+    for (SDNode *U : N->users())
+      if (U->getOpcode() == ISD::BR)
+        Br = U;
+    if (!Br)
+      return SDValue();
+    SDValue Header = Br->getOperand(1);
+    DAG.UpdateNodeOperands(Br, Br->getOperand(0), Dest);
+    Dest = Header;
+  }
+
+  SDValue LoopEnd = DAG.getNode(MWV208ISD::LOOP_END, SDLoc(N), MVT::Other,
+                                N->getOperand(0), Dest);
+  DAG.ReplaceAllUsesOfValueWith(Cond.getValue(1), Cond.getOperand(0));
+  ++NumHardwareLoops;
+  return LoopEnd;
+}
+
+static bool isSampleOpcode(unsigned Opc) {
+  switch (Opc) {
+  case MWV208ISD::SAMPLE:
+  case MWV208ISD::SAMPLE_LOD:
+  case MWV208ISD::SAMPLE_BIAS:
+  case MWV208ISD::GATHER:
+  case MWV208ISD::FETCH:
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// The sampler writes the texel through its own swizzle and the write mask
+/// of the destination. A permute of a texel nothing else reads is folded
+/// into SAMPLER_SWIZZLE, and a single lane of one becomes a sample into a
+/// component register, leaving the other three lanes of the register free.
+/// There are no register classes of two or three components, so a texel
+/// with that many lanes used still writes a whole register.
+static SDValue performSampleSwizzleCombine(SDNode *N, SelectionDAG &DAG) {
+  SDValue Texel = N->getOperand(0);
+  if (!isSampleOpcode(Texel.getOpcode()) || !Texel.hasOneUse())
+    return SDValue();
+
+  using namespace MWV208;
+  unsigned SwzIdx = Texel.getNumOperands() - 1;
+  unsigned Swz = Texel.getConstantOperandVal(SwzIdx);
+  unsigned NewSwz = 0;
+  if (N->getOpcode() == ISD::EXTRACT_VECTOR_ELT) {
+    auto *Lane = dyn_cast<ConstantSDNode>(N->getOperand(1));
+    if (!Lane || N->getValueType(0).getSizeInBits() != 32)
+      return SDValue();
+    // The lane allocated to the result is not known yet: a splat writes
+    // the component to whichever it is.
+    NewSwz = Swizzle::splat(Swizzle::getComponent(Swz, Lane->getZExtValue()));
+    ++NumScalarSamples;
+  } else {
+    auto *SVN = cast<ShuffleVectorSDNode>(N);
+    for (unsigned Lane = 0; Lane != 4; ++Lane) {
+      int Elt = SVN->getMaskElt(Lane);
+      if (Elt >= 4)
+        return SDValue();
+      NewSwz = Swizzle::setComponent(
+          NewSwz, Lane, Elt < 0 ? 0 : Swizzle::getComponent(Swz, Elt));
+    }
+  }
+
+  SmallVector<SDValue, 5> Ops(Texel->op_begin(), Texel->op_end());
+  Ops[SwzIdx] = DAG.getTargetConstant(NewSwz, SDLoc(N), MVT::i8);
+  return DAG.getNode(Texel.getOpcode(), SDLoc(N), N->getValueType(0), Ops);
+}
+
+SDValue Mwv208TargetLowering::PerformDAGCombine(SDNode *N,
+                                                DAGCombinerInfo &DCI) const {
+  switch (N->getOpcode()) {
+  case ISD::BRCOND:
+    return performBrCondCombine(N, DCI.DAG);
+  case ISD::EXTRACT_VECTOR_ELT:
+  case ISD::VECTOR_SHUFFLE:
+    return performSampleSwizzleCombine(N, DCI.DAG);
+  }
+
+  EVT VT = N->getValueType(0);
+  if (VT != MVT::f32 && VT != MVT::v4f32)
+    return SDValue();
+
+  switch (N->getOpcode()) {
+  case ISD::FADD:
+  case ISD::FMA:
+    return performDotCombine(N, DCI.DAG);
+  case ISD::VECREDUCE_FADD:
+    return performReduceFAddCombine(N, DCI.DAG);
+  }
+
+  if (SDValue X = matchClampToUnit(N))
+    return DCI.DAG.getNode(MWV208ISD::CLAMP, SDLoc(N), VT, X);
+  return SDValue();
+}
+
+bool Mwv208TargetLowering::isSDNodeSourceOfDivergence(
+    const SDNode *N, FunctionLoweringInfo *FLI, UniformityInfo *UA) const {
+  switch (N->getOpcode()) {
+  case ISD::CopyFromReg: {
+    Register Reg = cast<RegisterSDNode>(N->getOperand(1))->getReg();
+    if (const Value *V = FLI->getValueFromVirtualReg(Reg))
+      return UA->isDivergent(V);
+    // Not an IR value, assume the worst.
+    return true;
+  }
+  case MWV208ISD::PRIVATE_LOAD:
+    // Every thread has its own copy of a private array.
+    return true;
+  default:
+    return isa<AtomicSDNode>(N);
+  }
 }
 
 void Mwv208TargetLowering::computeKnownBitsForTargetNode(
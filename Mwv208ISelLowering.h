@@ -21,42 +21,39 @@
 namespace llvm {
 class Mwv208Subtarget;
 
-namespace SPISD {
+namespace MWV208ISD {
 enum NodeType : unsigned {
   FIRST_NUMBER = ISD::BUILTIN_OP_END,
-  CMPICC,     // Compare two GPR operands, set icc+xcc.
-  CMPFCC,     // Compare two FP operands, set fcc.
-  CMPFCC_V9,  // Compare two FP operands, set fcc (v9 variant).
-  BRICC,      // Branch to dest on icc condition
-  BRFCC,      // Branch to dest on fcc condition
-  BRFCC_V9,   // Branch to dest on fcc condition (v9 variant).
-  BR_REG,     // Branch to dest using the comparison of a register with zero.
-  SELECT_ICC, // Select between two values using the current ICC flags.
-  SELECT_XCC, // Select between two values using the current XCC flags.
-  SELECT_FCC, // Select between two values using the current FCC flags.
-  SELECT_REG, // Select between two values using the comparison of a register
-              // with zero.
-
-  Hi,
-  Lo, // Hi/Lo operations, typically on a global address.
-
-  FTOI, // FP to Int within a FP register.
-  ITOF, // Int to FP within a FP register.
-  FTOX, // FP to Int64 within a FP register.
-  XTOF, // Int64 to FP within a FP register.
-
-  CALL,            // A call instruction.
-  RET_GLUE,        // Return with a glue operand.
-  GLOBAL_BASE_REG, // Global base reg for PIC.
-  FLUSHW,          // FLUSH register windows to stack.
-
-  TAIL_CALL, // Tail call
-
-  TLS_ADD, // For Thread Local Storage (TLS).
-  TLS_LD,
-  TLS_CALL,
-
-  LOAD_GDOP, // Load operation w/ gdop relocation.
+  CLAMP, // Clamp a floating point value to [0.0, 1.0].
+  DP3,   // f32 dot product of the xyz components of two v4f32.
+  DP4,   // f32 dot product of two v4f32.
+  // A uniform in the constant bank. Operands are the index of the c register
+  // and the swizzle giving the component of each lane.
+  CONST_REG,
+  // The back edge of a hardware loop: decrement the loop counter and branch
+  // to the operand block while it is not zero. Has a chain.
+  LOOP_END,
+  // A uniform array argument, the pointer loads of it are based on. Operands
+  // are the first c register of the array and its size in bytes.
+  UNIFORM_ARRAY,
+  // Read a uniform array through a0. Operands are the c register, the
+  // component register for scalars, and the register index added to it.
+  CONST_LOAD,
+  // Texture sampling, see LowerCall. Operands are the coordinates, the lod,
+  // bias or gathered component when there is one, the sampler number and
+  // the swizzle applied to the texel.
+  SAMPLE,
+  SAMPLE_LOD,
+  SAMPLE_BIAS,
+  GATHER,
+  FETCH,
+  // Read and write a private array kept in temp registers, see
+  // Mwv208MachineFunctionInfo::getPrivateArray. Operands are the first
+  // register accessed, the first register of the array, its number of
+  // elements and the element index, zero when folded into the register.
+  // Both have a chain, PRIVATE_STORE takes the stored value first.
+  PRIVATE_LOAD = ISD::FIRST_TARGET_MEMORY_OPCODE,
+  PRIVATE_STORE,
 };
 }
 
@@ -65,10 +62,38 @@ class Mwv208TargetLowering : public TargetLowering {
 
 public:
   Mwv208TargetLowering(const TargetMachine &TM, const Mwv208Subtarget &STI);
-  // SDValue LowerOperation(SDValue Op, SelectionDAG &DAG) const override;
+  SDValue LowerOperation(SDValue Op, SelectionDAG &DAG) const override;
+  SDValue LowerLOAD(SDValue Op, SelectionDAG &DAG) const;
+  SDValue LowerSTORE(SDValue Op, SelectionDAG &DAG) const;
 
   bool useSoftFloat() const override;
 
+  /// Comparisons produce a 32-bit mask per lane.
+  EVT getSetCCResultType(const DataLayout &DL, LLVMContext &Context,
+                         EVT VT) const override;
+
+  SDValue LowerFormalArguments(SDValue Chain, CallingConv::ID CallConv,
+                               bool IsVarArg,
+                               const SmallVectorImpl<ISD::InputArg> &Ins,
+                               const SDLoc &DL, SelectionDAG &DAG,
+                               SmallVectorImpl<SDValue> &InVals) const override;
+
+  /// There are no function calls, only the texture builtins.
+  SDValue LowerCall(CallLoweringInfo &CLI,
+                    SmallVectorImpl<SDValue> &InVals) const override;
+
+  /// f32 literals are read from the constant bank like any other operand.
+  bool isFPImmLegal(const APFloat &Imm, EVT VT,
+                    bool ForCodeSize) const override;
+
+  /// Only shuffles of a single vector are swizzles. Keep the combiner from
+  /// forming others once they can no longer be lowered.
+  bool isShuffleMaskLegal(ArrayRef<int> Mask, EVT VT) const override;
+
+  /// Turn fmuladd and contractable fmul+fadd into fma, see mad.f32.
+  bool isFMAFasterThanFMulAndFAdd(const MachineFunction &MF,
+                                  EVT VT) const override;
+
   /// computeKnownBitsForTargetNode - Determine which of the bits specified
   /// in Mask are known to be either zero or one and return them in the
   /// KnownZero/KnownOne bitsets.
@@ -77,12 +102,19 @@ public:
                                      const SelectionDAG &DAG,
                                      unsigned Depth = 0) const override;
 
+  /// Divergence of values crossing blocks comes from the IR uniformity
+  /// analysis, the DAG propagates it from there.
+  bool isSDNodeSourceOfDivergence(const SDNode *N, FunctionLoweringInfo *FLI,
+                                  UniformityInfo *UA) const override;
+
   MachineBasicBlock *
   EmitInstrWithCustomInserter(MachineInstr &MI,
                               MachineBasicBlock *MBB) const override;
 
   const char *getTargetNodeName(unsigned Opcode) const override;
 
+  SDValue PerformDAGCombine(SDNode *N, DAGCombinerInfo &DCI) const override;
+
   ConstraintType getConstraintType(StringRef Constraint) const override;
   ConstraintWeight
   getSingleConstraintMatchWeight(AsmOperandInfo &info,
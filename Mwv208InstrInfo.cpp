@@ -12,7 +12,9 @@
 //===----------------------------------------------------------------------===//
 
 #include "Mwv208InstrInfo.h"
+#include "MCTargetDesc/Mwv208BaseInfo.h"
 #include "Mwv208.h"
+#include "Mwv208HazardRecognizer.h"
 #include "Mwv208MachineFunctionInfo.h"
 #include "Mwv208Subtarget.h"
 #include "llvm/ADT/SmallVector.h"
@@ -20,13 +22,23 @@
 #include "llvm/CodeGen/MachineInstrBuilder.h"
 #include "llvm/CodeGen/MachineMemOperand.h"
 #include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/CodeGen/MachineScheduler.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 
 using namespace llvm;
 
 #define GET_INSTRINFO_CTOR_DTOR
+#define GET_INSTRMAP_INFO
 #include "Mwv208GenInstrInfo.inc"
 
+// A predicated instruction still takes its issue slot when the predicate
+// fails, a branch around it costs a control flow instruction and a refetch.
+static cl::opt<unsigned> IfCvtLimit(
+    "mwv208-ifcvt-limit", cl::Hidden, cl::init(8),
+    cl::desc("Maximum number of instructions if-conversion predicates in "
+             "place of a branch"));
+
 // Pin the vtable to this file.
 void Mwv208InstrInfo::anchor() {}
 
@@ -38,10 +50,482 @@ void Mwv208InstrInfo::copyPhysReg(MachineBasicBlock &MBB,
                                   const DebugLoc &DL, MCRegister DestReg,
                                   MCRegister SrcReg, bool KillSrc,
                                   bool RenamableDest, bool RenamableSrc) const {
-  /*   if (MWV208::IntRegsRegClass.contains(DestReg, SrcReg)) {
-      BuildMI(MBB, I, DL, get(MWV208::ORrr), DestReg)
-          .addReg(MWV208::G0)
-          .addReg(SrcReg, getKillRegState(KillSrc));
-    } else
-      llvm_unreachable("Impossible reg-to-reg copy"); */
-}
\ No newline at end of file
+  // A component register as destination encodes its own single-lane write
+  // mask, and as source is read through a splat of its lane by the encoder.
+  // A whole register copied into a component provides its lane x; a
+  // component copied into a whole register is read through its parent.
+  bool DestIsComp = MWV208::Component32RegClass.contains(DestReg);
+  bool SrcIsComp = MWV208::Component32RegClass.contains(SrcReg);
+  unsigned Opc, Swizzle;
+  if (DestIsComp && SrcIsComp) {
+    Opc = MWV208::MOV_s;
+    Swizzle = MWV208::Swizzle::XXXX;
+  } else if (DestIsComp) {
+    Opc = MWV208::MOVC;
+    Swizzle = MWV208::Swizzle::XXXX;
+  } else if (SrcIsComp) {
+    unsigned Lane = MWV208::getComponentLane(RI.getEncodingValue(SrcReg));
+    SrcReg = RI.getMatchingSuperReg(SrcReg, MWV208::getComponentSubReg(Lane),
+                                    &MWV208::TempRegClassRegClass);
+    Opc = MWV208::MOV;
+    Swizzle = MWV208::Swizzle::splat(Lane);
+  } else {
+    Opc = MWV208::MOV;
+    Swizzle = MWV208::Swizzle::XYZW;
+  }
+
+  if (!MWV208::TempRegClassRegClass.contains(DestReg) && !DestIsComp)
+    llvm_unreachable("Impossible reg-to-reg copy");
+
+  BuildMI(MBB, I, DL, get(Opc), DestReg)
+      .addReg(SrcReg, getKillRegState(KillSrc))
+      .addImm(Swizzle)
+      .addImm(0) // mod
+      .addImm(0) // sat
+      .addImm(MWV208::COND_TRUE)
+      .addReg(MWV208::NoRegister);
+}
+
+// Private arrays hold one element per temp register, scalars in lane x.
+static MCRegister getPrivateReg(unsigned Idx, bool IsScalar) {
+  if (IsScalar)
+    return MWV208::Component32RegClass.getRegister(Idx * 4);
+  return MWV208::TempRegClassRegClass.getRegister(Idx);
+}
+
+// Relative accesses add a0.x to the register address. It is written right
+// before the access that reads it.
+static void buildMovA(MachineBasicBlock &MBB, MachineInstr &MI,
+                      const MachineOperand &Idx, const TargetInstrInfo &TII) {
+  BuildMI(MBB, MI, MI.getDebugLoc(), TII.get(MWV208::MOVA_s), MWV208::a0x)
+      .addReg(Idx.getReg(), getKillRegState(Idx.isKill()))
+      .addImm(MWV208::Swizzle::XXXX)
+      .addImm(0)  // mod
+      .addImm(0); // sat
+}
+
+bool Mwv208InstrInfo::expandPostRAPseudo(MachineInstr &MI) const {
+  MachineBasicBlock &MBB = *MI.getParent();
+  const DebugLoc &DL = MI.getDebugLoc();
+  bool IsScalar;
+  bool IsLoad;
+  switch (MI.getOpcode()) {
+  default:
+    return false;
+  case MWV208::CONST_LOAD:
+  case MWV208::CONST_LOAD_s: {
+    // CONST_LOAD is (dst, reg, idx), reg numbering the components of the c
+    // registers for scalars. The c registers never change, so unlike
+    // PRIV_LOAD nothing else has to be told about the access.
+    IsScalar = MI.getOpcode() == MWV208::CONST_LOAD_s;
+    unsigned Reg = MI.getOperand(1).getImm();
+    buildMovA(MBB, MI, MI.getOperand(2), *this);
+    BuildMI(MBB, MI, DL, get(IsScalar ? MWV208::MOV_s : MWV208::MOV),
+            MI.getOperand(0).getReg())
+        .addReg(IsScalar ? MWV208::Const32RegClass.getRegister(Reg)
+                         : MWV208::ConstRegClassRegClass.getRegister(Reg))
+        .addImm(IsScalar ? MWV208::Swizzle::XXXX : MWV208::Swizzle::XYZW)
+        .addImm(MWV208::REL_A0_X << MWV208::SrcMod::REL_SHIFT)
+        .addImm(0) // sat
+        .addImm(MWV208::COND_TRUE)
+        .addReg(MWV208::NoRegister)
+        .addReg(MWV208::a0x, RegState::Implicit | RegState::Kill);
+    MI.eraseFromParent();
+    return true;
+  }
+  case MWV208::PRIV_LOAD_i:
+  case MWV208::PRIV_LOAD_i_s: {
+    IsScalar = MI.getOpcode() == MWV208::PRIV_LOAD_i_s;
+    copyPhysReg(MBB, MI, DL, MI.getOperand(0).getReg(),
+                getPrivateReg(MI.getOperand(1).getImm(), IsScalar), false);
+    MI.eraseFromParent();
+    return true;
+  }
+  case MWV208::PRIV_STORE_i:
+  case MWV208::PRIV_STORE_i_s: {
+    IsScalar = MI.getOpcode() == MWV208::PRIV_STORE_i_s;
+    copyPhysReg(MBB, MI, DL,
+                getPrivateReg(MI.getOperand(1).getImm(), IsScalar),
+                MI.getOperand(0).getReg(), MI.getOperand(0).isKill());
+    MI.eraseFromParent();
+    return true;
+  }
+  case MWV208::PRIV_LOAD:
+    IsScalar = false;
+    IsLoad = true;
+    break;
+  case MWV208::PRIV_LOAD_s:
+    IsScalar = true;
+    IsLoad = true;
+    break;
+  case MWV208::PRIV_STORE:
+    IsScalar = false;
+    IsLoad = false;
+    break;
+  case MWV208::PRIV_STORE_s:
+    IsScalar = true;
+    IsLoad = false;
+    break;
+  }
+
+  // PRIV_LOAD is (dst, reg, first, size, idx), PRIV_STORE (src, reg, first,
+  // size, idx).
+  MCRegister Reg = getPrivateReg(MI.getOperand(1).getImm(), IsScalar);
+  unsigned First = MI.getOperand(2).getImm();
+  unsigned Size = MI.getOperand(3).getImm();
+  buildMovA(MBB, MI, MI.getOperand(4), *this);
+
+  unsigned Swizzle =
+      IsScalar ? MWV208::Swizzle::XXXX : MWV208::Swizzle::XYZW;
+  MachineInstrBuilder MIB;
+  if (IsLoad) {
+    MIB = BuildMI(MBB, MI, DL, get(IsScalar ? MWV208::MOV_s : MWV208::MOV),
+                  MI.getOperand(0).getReg())
+              .addReg(Reg)
+              .addImm(Swizzle)
+              .addImm(MWV208::REL_A0_X << MWV208::SrcMod::REL_SHIFT)
+              .addImm(0) // sat
+              .addImm(MWV208::COND_TRUE)
+              .addReg(MWV208::NoRegister);
+  } else {
+    const MachineOperand &Src = MI.getOperand(0);
+    MIB = BuildMI(MBB, MI, DL, get(IsScalar ? MWV208::MOVRD_s : MWV208::MOVRD),
+                  Reg)
+              .addReg(Src.getReg(), getKillRegState(Src.isKill()))
+              .addImm(Swizzle)
+              .addImm(0) // mod
+              .addImm(MWV208::REL_A0_X)
+              .addImm(0); // sat
+  }
+
+  // The register actually accessed is only known at run time: tell later
+  // passes the move may touch any element of the array.
+  MIB.addReg(MWV208::a0x, RegState::Implicit | RegState::Kill);
+  for (unsigned I = First, E = First + Size; I != E; ++I) {
+    MCRegister Elt = MWV208::TempRegClassRegClass.getRegister(I);
+    MIB.addReg(Elt, RegState::Implicit);
+    if (!IsLoad)
+      MIB.addReg(Elt, RegState::ImplicitDefine);
+  }
+  MI.eraseFromParent();
+  return true;
+}
+
+static bool isCondBranch(unsigned Opc) {
+  return Opc == MWV208::BRCOND_s || Opc == MWV208::BRCOND_DIV;
+}
+
+// BRCOND_s and BRCOND_DIV operands are (reg, swizzle, mod, cc, target). The
+// condition of a BRCOND_DIV carries its opcode as a fifth component, so that
+// insertBranch puts the same branch back. Only early if-conversion sees it,
+// see Mwv208PassConfig::addInstSelector.
+static void parseCondBranch(MachineInstr &MI, MachineBasicBlock *&Target,
+                            SmallVectorImpl<MachineOperand> &Cond) {
+  Cond.push_back(MI.getOperand(3));
+  Cond.push_back(MI.getOperand(0));
+  Cond.push_back(MI.getOperand(1));
+  Cond.push_back(MI.getOperand(2));
+  if (MI.getOpcode() == MWV208::BRCOND_DIV)
+    Cond.push_back(MachineOperand::CreateImm(MWV208::BRCOND_DIV));
+  Target = MI.getOperand(4).getMBB();
+}
+
+bool Mwv208InstrInfo::analyzeBranch(MachineBasicBlock &MBB,
+                                    MachineBasicBlock *&TBB,
+                                    MachineBasicBlock *&FBB,
+                                    SmallVectorImpl<MachineOperand> &Cond,
+                                    bool AllowModify) const {
+  MachineBasicBlock::iterator I = MBB.getLastNonDebugInstr();
+  if (I == MBB.end() || !isUnpredicatedTerminator(*I))
+    return false;
+
+  MachineInstr *LastInst = &*I;
+  unsigned LastOpc = LastInst->getOpcode();
+
+  // If there is only one terminator instruction, process it. ENDLOOP and
+  // vec4 conditions are left alone.
+  if (I == MBB.begin() || !isUnpredicatedTerminator(*--I)) {
+    if (LastOpc == MWV208::BR) {
+      TBB = LastInst->getOperand(0).getMBB();
+      return false;
+    }
+    if (isCondBranch(LastOpc)) {
+      parseCondBranch(*LastInst, TBB, Cond);
+      return false;
+    }
+    return true;
+  }
+
+  MachineInstr *SecondLastInst = &*I;
+  unsigned SecondLastOpc = SecondLastInst->getOpcode();
+
+  // If AllowModify is true and the block ends with two or more unconditional
+  // branches, delete all but the first one.
+  if (AllowModify && LastOpc == MWV208::BR) {
+    while (SecondLastOpc == MWV208::BR) {
+      LastInst->eraseFromParent();
+      LastInst = SecondLastInst;
+      LastOpc = LastInst->getOpcode();
+      if (I == MBB.begin() || !isUnpredicatedTerminator(*--I)) {
+        TBB = LastInst->getOperand(0).getMBB();
+        return false;
+      }
+      SecondLastInst = &*I;
+      SecondLastOpc = SecondLastInst->getOpcode();
+    }
+  }
+
+  // If there are three terminators, we don't know what sort of block this is.
+  if (I != MBB.begin() && isUnpredicatedTerminator(*--I))
+    return true;
+
+  if (isCondBranch(SecondLastOpc) && LastOpc == MWV208::BR) {
+    parseCondBranch(*SecondLastInst, TBB, Cond);
+    FBB = LastInst->getOperand(0).getMBB();
+    return false;
+  }
+
+  // The second of two unconditional branches is dead.
+  if (SecondLastOpc == MWV208::BR && LastOpc == MWV208::BR) {
+    TBB = SecondLastInst->getOperand(0).getMBB();
+    if (AllowModify)
+      LastInst->eraseFromParent();
+    return false;
+  }
+
+  return true;
+}
+
+unsigned Mwv208InstrInfo::removeBranch(MachineBasicBlock &MBB,
+                                       int *BytesRemoved) const {
+  MachineBasicBlock::iterator I = MBB.end();
+  unsigned Count = 0;
+  while (I != MBB.begin()) {
+    --I;
+    if (I->isDebugInstr())
+      continue;
+    if (I->getOpcode() != MWV208::BR && !isCondBranch(I->getOpcode()))
+      break;
+    I->eraseFromParent();
+    I = MBB.end();
+    ++Count;
+  }
+
+  if (BytesRemoved)
+    *BytesRemoved = Count * 16;
+  return Count;
+}
+
+unsigned Mwv208InstrInfo::insertBranch(MachineBasicBlock &MBB,
+                                       MachineBasicBlock *TBB,
+                                       MachineBasicBlock *FBB,
+                                       ArrayRef<MachineOperand> Cond,
+                                       const DebugLoc &DL,
+                                       int *BytesAdded) const {
+  assert(TBB && "insertBranch must not be told to insert a fallthrough");
+  assert((Cond.size() == 4 || Cond.size() == 5 || Cond.size() == 0) &&
+         "MWV208 branch conditions have four or five components!");
+
+  unsigned Count = 1;
+  if (Cond.empty()) {
+    assert(!FBB && "Unconditional branch with multiple successors!");
+    BuildMI(&MBB, DL, get(MWV208::BR)).addMBB(TBB);
+  } else {
+    unsigned Opc = Cond.size() == 5 ? Cond[4].getImm() : MWV208::BRCOND_s;
+    BuildMI(&MBB, DL, get(Opc))
+        .add(Cond[1])
+        .add(Cond[2])
+        .add(Cond[3])
+        .add(Cond[0])
+        .addMBB(TBB);
+    if (FBB) {
+      BuildMI(&MBB, DL, get(MWV208::BR)).addMBB(FBB);
+      ++Count;
+    }
+  }
+
+  if (BytesAdded)
+    *BytesAdded = Count * 16;
+  return Count;
+}
+
+bool Mwv208InstrInfo::reverseBranchCondition(
+    SmallVectorImpl<MachineOperand> &Cond) const {
+  assert((Cond.size() == 4 || Cond.size() == 5) &&
+         "Invalid branch condition!");
+  auto CC = static_cast<MWV208::CondCode>(Cond[0].getImm());
+  if (CC == MWV208::COND_TRUE)
+    return true;
+  Cond[0].setImm(MWV208::getOppositeCondition(CC));
+  return false;
+}
+
+bool Mwv208InstrInfo::isPredicated(const MachineInstr &MI) const {
+  int Idx = MI.findFirstPredOperandIdx();
+  return Idx >= 0 && MI.getOperand(Idx).getImm() != MWV208::COND_TRUE;
+}
+
+// The predicate takes the place of SRC2, which has room for neither a
+// swizzle other than a splat nor modifiers, and can only read a temp
+// register. Branch conditions are selected in that form, see BRCOND_s.
+bool Mwv208InstrInfo::PredicateInstruction(
+    MachineInstr &MI, ArrayRef<MachineOperand> Pred) const {
+  int Idx = MI.findFirstPredOperandIdx();
+  if (Idx < 0 || Pred.size() != 4 || isPredicated(MI))
+    return false;
+
+  Register Reg = Pred[1].getReg();
+  if (!MWV208::Component32RegClass.contains(Reg) ||
+      Pred[2].getImm() != MWV208::Swizzle::XXXX || Pred[3].getImm() != 0)
+    return false;
+
+  MI.getOperand(Idx).setImm(Pred[0].getImm());
+  MI.getOperand(Idx + 1).setReg(Reg);
+  return true;
+}
+
+bool Mwv208InstrInfo::SubsumesPredicate(ArrayRef<MachineOperand> Pred1,
+                                        ArrayRef<MachineOperand> Pred2) const {
+  if (Pred1.size() != 4 || Pred2.size() != 4 ||
+      Pred1[1].getReg() != Pred2[1].getReg() ||
+      Pred1[2].getImm() != Pred2[2].getImm() ||
+      Pred1[3].getImm() != Pred2[3].getImm())
+    return false;
+
+  unsigned CC1 = Pred1[0].getImm();
+  unsigned CC2 = Pred2[0].getImm();
+  if (CC1 == CC2 || CC1 == MWV208::COND_TRUE)
+    return true;
+  switch (CC1) {
+  default:
+    return false;
+  case MWV208::COND_GE:
+    return CC2 == MWV208::COND_GT || CC2 == MWV208::COND_EQ;
+  case MWV208::COND_LE:
+    return CC2 == MWV208::COND_LT || CC2 == MWV208::COND_EQ;
+  case MWV208::COND_NE:
+    return CC2 == MWV208::COND_GT || CC2 == MWV208::COND_LT;
+  }
+}
+
+// Any component can serve as a predicate. The ones that matter are the
+// conditions of the branches into the block, which if-conversion turns into
+// the predicates of its instructions.
+bool Mwv208InstrInfo::ClobbersPredicate(MachineInstr &MI,
+                                        std::vector<MachineOperand> &Pred,
+                                        bool SkipDead) const {
+  bool Found = false;
+  for (MachineBasicBlock *PredMBB : MI.getParent()->predecessors()) {
+    for (MachineInstr &Term : PredMBB->terminators()) {
+      if (Term.getOpcode() != MWV208::BRCOND_s)
+        continue;
+      Register CondReg = Term.getOperand(0).getReg();
+      for (MachineOperand &MO : MI.operands()) {
+        if (!MO.isReg() || !MO.isDef() || (SkipDead && MO.isDead()) ||
+            !RI.regsOverlap(MO.getReg(), CondReg))
+          continue;
+        Pred.push_back(MO);
+        Found = true;
+      }
+    }
+  }
+  return Found;
+}
+
+bool Mwv208InstrInfo::isProfitableToIfCvt(
+    MachineBasicBlock &MBB, unsigned NumCycles, unsigned ExtraPredCycles,
+    BranchProbability Probability) const {
+  return NumCycles + ExtraPredCycles <= IfCvtLimit;
+}
+
+bool Mwv208InstrInfo::isProfitableToIfCvt(
+    MachineBasicBlock &TMBB, unsigned NumTCycles, unsigned ExtraTCycles,
+    MachineBasicBlock &FMBB, unsigned NumFCycles, unsigned ExtraFCycles,
+    BranchProbability Probability) const {
+  return NumTCycles + ExtraTCycles + NumFCycles + ExtraFCycles <= IfCvtLimit;
+}
+
+// Duplicated blocks are paid for in every predecessor.
+bool Mwv208InstrInfo::isProfitableToDupForIfCvt(
+    MachineBasicBlock &MBB, unsigned NumCycles,
+    BranchProbability Probability) const {
+  return NumCycles <= IfCvtLimit / 4;
+}
+
+bool Mwv208InstrInfo::canInsertSelect(const MachineBasicBlock &MBB,
+                                      ArrayRef<MachineOperand> Cond,
+                                      Register DstReg, Register TrueReg,
+                                      Register FalseReg, int &CondCycles,
+                                      int &TrueCycles,
+                                      int &FalseCycles) const {
+  if (Cond.size() != 4 && Cond.size() != 5)
+    return false;
+
+  // Whole registers would need the condition splat into a vector first.
+  const MachineRegisterInfo &MRI = MBB.getParent()->getRegInfo();
+  const TargetRegisterClass *RC = RI.getCommonSubClass(
+      MRI.getRegClass(TrueReg), MRI.getRegClass(FalseReg));
+  if (!RC || !MWV208::Component32RegClass.hasSubClassEq(RC))
+    return false;
+
+  // sel reads the condition directly, no compare is needed.
+  CondCycles = 0;
+  TrueCycles = FalseCycles = 1;
+  return true;
+}
+
+void Mwv208InstrInfo::insertSelect(MachineBasicBlock &MBB,
+                                   MachineBasicBlock::iterator I,
+                                   const DebugLoc &DL, Register DstReg,
+                                   ArrayRef<MachineOperand> Cond,
+                                   Register TrueReg, Register FalseReg) const {
+  BuildMI(MBB, I, DL, get(MWV208::SELECT_s), DstReg)
+      .addReg(Cond[1].getReg())
+      .addImm(Cond[2].getImm())
+      .addImm(Cond[3].getImm())
+      .addReg(TrueReg)
+      .addImm(MWV208::Swizzle::XXXX)
+      .addImm(0) // mod
+      .addReg(FalseReg)
+      .addImm(MWV208::Swizzle::XXXX)
+      .addImm(0) // mod
+      .addImm(Cond[0].getImm())
+      .addImm(0); // sat
+}
+bool Mwv208InstrInfo::isBasicBlockPrologue(const MachineInstr &MI,
+                                           Register Reg) const {
+  return MI.getOpcode() == MWV208::ENDIF;
+}
+
+void Mwv208InstrInfo::insertNoop(MachineBasicBlock &MBB,
+                                 MachineBasicBlock::iterator MI) const {
+  BuildMI(MBB, MI, DebugLoc(), get(MWV208::NOP));
+}
+
+// The same recognizer first lets the post-RA scheduler fill the waits, then
+// has the remaining ones filled with nops.
+ScheduleHazardRecognizer *
+Mwv208InstrInfo::CreateTargetMIHazardRecognizer(const InstrItineraryData *II,
+                                                const ScheduleDAGMI *DAG) const {
+  // Only the post-RA scheduler runs after the pipeline is known.
+  if (DAG->hasVRegLiveness())
+    return TargetInstrInfo::CreateTargetMIHazardRecognizer(II, DAG);
+  return new Mwv208HazardRecognizer(DAG->MF);
+}
+
+ScheduleHazardRecognizer *Mwv208InstrInfo::CreateTargetPostRAHazardRecognizer(
+    const MachineFunction &MF) const {
+  return new Mwv208HazardRecognizer(MF);
+}
+
+bool Mwv208InstrInfo::isSchedulingBoundary(const MachineInstr &MI,
+                                           const MachineBasicBlock *MBB,
+                                           const MachineFunction &MF) const {
+  switch (MI.getOpcode()) {
+  case MWV208::ENDIF:
+  case MWV208::WHILE:
+    return true;
+  default:
+    return TargetInstrInfo::isSchedulingBoundary(MI, MBB, MF);
+  }
+}
@@ -14,6 +14,7 @@
 #ifndef LLVM_LIB_TARGET_MWV208_MWV208INSTRINFO_H
 #define LLVM_LIB_TARGET_MWV208_MWV208INSTRINFO_H
 
+#include "MCTargetDesc/Mwv208BaseInfo.h"
 #include "Mwv208RegisterInfo.h"
 #include "llvm/CodeGen/TargetInstrInfo.h"
 
@@ -24,6 +25,12 @@ namespace llvm {
 
 class Mwv208Subtarget;
 
+namespace MWV208 {
+/// The vec4 form of a scalar (_s) instruction that computes each lane on
+/// its own, or -1. Generated from Mwv208Lanewise.
+LLVM_READONLY int getVectorOpcode(uint16_t Opcode);
+} // end namespace MWV208
+
 class Mwv208InstrInfo : public Mwv208GenInstrInfo {
   const Mwv208RegisterInfo RI;
   virtual void anchor();
@@ -41,6 +48,80 @@ public:
                    const DebugLoc &DL, MCRegister DestReg, MCRegister SrcReg,
                    bool KillSrc, bool RenamableDest = false,
                    bool RenamableSrc = false) const override;
+
+  /// Expand the private and uniform array pseudos into moves through a0,
+  /// see PRIV_LOAD and CONST_LOAD.
+  bool expandPostRAPseudo(MachineInstr &MI) const override;
+
+  /// Branch analysis. A conditional branch is described by the operands
+  /// {cc, reg, swizzle, mod}: it is taken when the component tests cc
+  /// against zero.
+  bool analyzeBranch(MachineBasicBlock &MBB, MachineBasicBlock *&TBB,
+                     MachineBasicBlock *&FBB,
+                     SmallVectorImpl<MachineOperand> &Cond,
+                     bool AllowModify = false) const override;
+  unsigned removeBranch(MachineBasicBlock &MBB,
+                        int *BytesRemoved = nullptr) const override;
+  unsigned insertBranch(MachineBasicBlock &MBB, MachineBasicBlock *TBB,
+                        MachineBasicBlock *FBB, ArrayRef<MachineOperand> Cond,
+                        const DebugLoc &DL,
+                        int *BytesAdded = nullptr) const override;
+  bool
+  reverseBranchCondition(SmallVectorImpl<MachineOperand> &Cond) const override;
+
+  /// Predication. Predicates have the shape of branch conditions, see
+  /// Mwv208Pred in Mwv208InstrFormats.td.
+  bool isPredicated(const MachineInstr &MI) const override;
+  bool PredicateInstruction(MachineInstr &MI,
+                            ArrayRef<MachineOperand> Pred) const override;
+  bool SubsumesPredicate(ArrayRef<MachineOperand> Pred1,
+                         ArrayRef<MachineOperand> Pred2) const override;
+  bool ClobbersPredicate(MachineInstr &MI, std::vector<MachineOperand> &Pred,
+                         bool SkipDead) const override;
+
+  bool isProfitableToIfCvt(MachineBasicBlock &MBB, unsigned NumCycles,
+                           unsigned ExtraPredCycles,
+                           BranchProbability Probability) const override;
+  bool isProfitableToIfCvt(MachineBasicBlock &TMBB, unsigned NumTCycles,
+                           unsigned ExtraTCycles, MachineBasicBlock &FMBB,
+                           unsigned NumFCycles, unsigned ExtraFCycles,
+                           BranchProbability Probability) const override;
+  bool isProfitableToDupForIfCvt(MachineBasicBlock &MBB, unsigned NumCycles,
+                                 BranchProbability Probability) const override;
+
+  /// Early if-conversion of scalars, through SELECT_s.
+  bool canInsertSelect(const MachineBasicBlock &MBB,
+                       ArrayRef<MachineOperand> Cond, Register DstReg,
+                       Register TrueReg, Register FalseReg, int &CondCycles,
+                       int &TrueCycles, int &FalseCycles) const override;
+  void insertSelect(MachineBasicBlock &MBB, MachineBasicBlock::iterator I,
+                    const DebugLoc &DL, Register DstReg,
+                    ArrayRef<MachineOperand> Cond, Register TrueReg,
+                    Register FalseReg) const override;
+
+  /// ENDIF restores the lanes of the enclosing region, so the copies PHI
+  /// elimination puts at the start of a join must come after it.
+  bool isBasicBlockPrologue(const MachineInstr &MI,
+                            Register Reg = Register()) const override;
+
+  /// Texture samples, see Mwv208SchedStrategy.
+  static bool isSample(const MachineInstr &MI) {
+    return MI.getDesc().TSFlags & MWV208II::IsSample;
+  }
+
+  /// Hazards are covered with nops, see Mwv208HazardRecognizer.
+  void insertNoop(MachineBasicBlock &MBB,
+                  MachineBasicBlock::iterator MI) const override;
+  ScheduleHazardRecognizer *
+  CreateTargetMIHazardRecognizer(const InstrItineraryData *II,
+                                 const ScheduleDAGMI *DAG) const override;
+  ScheduleHazardRecognizer *
+  CreateTargetPostRAHazardRecognizer(const MachineFunction &MF) const override;
+
+  /// Nothing may be moved across a change of the execution mask.
+  bool isSchedulingBoundary(const MachineInstr &MI,
+                            const MachineBasicBlock *MBB,
+                            const MachineFunction &MF) const override;
 };
 
 // 目标架构特有的TargetInstrInfo子类
@@ -8,6 +8,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "Mwv208MachineFunctionInfo.h"
+#include "MCTargetDesc/Mwv208BaseInfo.h"
+#include "llvm/Support/MathExtras.h"
 
 using namespace llvm;
 
@@ -19,3 +21,122 @@ MachineFunctionInfo *Mwv208MachineFunctionInfo::clone(
     const {
   return DestMF.cloneInfo<Mwv208MachineFunctionInfo>(*this);
 }
+
+std::optional<Mwv208PrivateArray>
+Mwv208MachineFunctionInfo::getPrivateArray(int FI, uint64_t ObjectSize,
+                                           unsigned EltBytes,
+                                           unsigned NumTempRegs) {
+  auto It = PrivateArrays.find(FI);
+  if (It != PrivateArrays.end()) {
+    if (It->second.EltBytes != EltBytes)
+      return std::nullopt;
+    return It->second;
+  }
+
+  uint64_t NumElts = divideCeil(ObjectSize, EltBytes);
+  if (NumElts == 0 || NumPrivateRegs + NumElts > NumTempRegs / 2)
+    return std::nullopt;
+  Mwv208PrivateArray A{NumPrivateRegs, unsigned(NumElts), EltBytes};
+  NumPrivateRegs += A.NumElts;
+  PrivateArrays[FI] = A;
+  return A;
+}
+
+std::optional<Mwv208ConstantBank::Slot>
+Mwv208ConstantBank::addUniform(unsigned ArgNo, unsigned ByteOffset,
+                               unsigned ArgSize, unsigned NumLanes) {
+  assert((NumLanes == 1 || NumLanes == 4) && "Not a scalar or a vec4");
+  // Uniforms are placed before any literal, so only the last register can
+  // have a free lane.
+  if (NumLanes == 1 && !Regs.empty()) {
+    Register4 &R = Regs.back();
+    for (unsigned C = 0; C != 4; ++C) {
+      if (R[C].Kind != Mwv208ConstLane::Unused)
+        continue;
+      R[C] = {Mwv208ConstLane::Uniform, ArgNo << 16 | ByteOffset};
+      return Slot{unsigned(Regs.size() - 1), MWV208::Swizzle::splat(C)};
+    }
+  }
+
+  if (Regs.size() == MaxRegs)
+    return std::nullopt;
+  Register4 &R = Regs.emplace_back();
+  for (unsigned C = 0; C != NumLanes; ++C) {
+    unsigned Offset = ByteOffset + C * 4;
+    if (Offset < ArgSize)
+      R[C] = {Mwv208ConstLane::Uniform, ArgNo << 16 | Offset};
+  }
+  return Slot{unsigned(Regs.size() - 1), MWV208::Swizzle::XYZW};
+}
+
+std::optional<unsigned>
+Mwv208ConstantBank::addUniformArray(unsigned ArgNo, unsigned ArgSize) {
+  unsigned First = Regs.size();
+  if (First + divideCeil(ArgSize, 16) > MaxRegs)
+    return std::nullopt;
+  for (unsigned Offset = 0; Offset < ArgSize; Offset += 4) {
+    if (Offset % 16 == 0)
+      Regs.emplace_back();
+    Regs.back()[Offset % 16 / 4] = {Mwv208ConstLane::Uniform,
+                                    ArgNo << 16 | Offset};
+  }
+  return First;
+}
+
+std::optional<Mwv208ConstantBank::Slot>
+Mwv208ConstantBank::addLiterals(ArrayRef<std::optional<uint32_t>> Lanes) {
+  assert((Lanes.size() == 1 || Lanes.size() == 4) && "Not a scalar or a vec4");
+  SmallVector<uint32_t, 4> Values;
+  for (const std::optional<uint32_t> &V : Lanes)
+    if (V && !is_contained(Values, *V))
+      Values.push_back(*V);
+  if (Values.empty())
+    Values.push_back(0);
+
+  auto findLiteral = [](const Register4 &R, uint32_t V) -> int {
+    for (unsigned C = 0; C != 4; ++C)
+      if (R[C].Kind == Mwv208ConstLane::Literal && R[C].Value == V)
+        return C;
+    return -1;
+  };
+
+  // Use the first register that already holds the values, or has room for
+  // the missing ones.
+  unsigned Idx = 0;
+  for (unsigned E = Regs.size(); Idx != E; ++Idx) {
+    const Register4 &R = Regs[Idx];
+    unsigned Free = count_if(R, [](const Mwv208ConstLane &L) {
+      return L.Kind == Mwv208ConstLane::Unused;
+    });
+    unsigned Missing = count_if(
+        Values, [&](uint32_t V) { return findLiteral(R, V) < 0; });
+    if (Missing <= Free)
+      break;
+  }
+  if (Idx == Regs.size()) {
+    if (Regs.size() == MaxRegs)
+      return std::nullopt;
+    Regs.emplace_back();
+  }
+
+  Register4 &R = Regs[Idx];
+  for (uint32_t V : Values) {
+    if (findLiteral(R, V) >= 0)
+      continue;
+    for (Mwv208ConstLane &L : R) {
+      if (L.Kind != Mwv208ConstLane::Unused)
+        continue;
+      L = {Mwv208ConstLane::Literal, V};
+      break;
+    }
+  }
+
+  // Undefined lanes read the first value.
+  unsigned Swizzle = 0;
+  for (unsigned Lane = 0; Lane != 4; ++Lane) {
+    const std::optional<uint32_t> &V = Lanes[Lanes.size() == 1 ? 0 : Lane];
+    Swizzle = MWV208::Swizzle::setComponent(Swizzle, Lane,
+                                            findLiteral(R, V ? *V : Values[0]));
+  }
+  return Slot{Idx, Swizzle};
+}
@@ -13,10 +13,73 @@
 #ifndef LLVM_LIB_TARGET_MWV208_MWV208MACHINEFUNCTIONINFO_H
 #define LLVM_LIB_TARGET_MWV208_MWV208MACHINEFUNCTIONINFO_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/CodeGen/MachineFunction.h"
+#include <array>
+#include <optional>
 
 namespace llvm {
 
+/// One 32-bit lane of the constant register file.
+struct Mwv208ConstLane {
+  enum KindTy : uint8_t { Unused, Literal, Uniform };
+
+  KindTy Kind = Unused;
+  /// Literal: the bit pattern. Uniform: the argument number in the high half,
+  /// the byte offset of the lane inside the argument in the low half.
+  uint32_t Value = 0;
+};
+
+/// Mwv208ConstantBank - Contents of the constant registers c0-c31 of a
+/// kernel: its uniform arguments, followed by the literals it reads, four
+/// 32-bit lanes per register. The driver uploads the bank once per launch, so
+/// reading a uniform or a literal needs no instruction at all.
+class Mwv208ConstantBank {
+public:
+  using Register4 = std::array<Mwv208ConstLane, 4>;
+
+  /// Size of the constant register file, see ConstRegClass.
+  static constexpr unsigned MaxRegs = 32;
+
+  /// Where a value lives: register c<Reg>, lane i of the value being
+  /// component i of Swizzle.
+  struct Slot {
+    unsigned Reg;
+    unsigned Swizzle;
+  };
+
+  /// Place \p NumLanes lanes of argument \p ArgNo, starting \p ByteOffset
+  /// bytes into it. Scalars share registers, vectors take a whole one. Lanes
+  /// at or past \p ArgSize bytes are padding and left unused.
+  std::optional<Slot> addUniform(unsigned ArgNo, unsigned ByteOffset,
+                                 unsigned ArgSize, unsigned NumLanes);
+
+  /// Place the \p ArgSize bytes of uniform array \p ArgNo in order, sixteen
+  /// bytes per register starting at a new one, and return the first
+  /// register. Whole registers let an element be picked through a0.
+  std::optional<unsigned> addUniformArray(unsigned ArgNo, unsigned ArgSize);
+
+  /// Place a scalar or vec4 literal, lanes without a value being undefined.
+  /// Values already in the bank are reused, and the lanes of a vector may be
+  /// spread over a register in any order since the swizzle gathers them.
+  std::optional<Slot> addLiterals(ArrayRef<std::optional<uint32_t>> Lanes);
+
+  ArrayRef<Register4> registers() const { return Regs; }
+  bool empty() const { return Regs.empty(); }
+
+private:
+  SmallVector<Register4, 8> Regs;
+};
+
+/// A private array kept in temp registers r<Base> to r<Base+NumElts-1>, one
+/// element per register, so that it can be indexed through a0.
+struct Mwv208PrivateArray {
+  unsigned Base;
+  unsigned NumElts;
+  unsigned EltBytes;
+};
+
 class Mwv208MachineFunctionInfo : public MachineFunctionInfo {
   virtual void anchor();
 
@@ -33,6 +96,14 @@ private:
   /// IsLeafProc - True if the function is a leaf procedure.
   bool IsLeafProc;
 
+  /// ConstantBank - Uniforms and literals placed in the c registers.
+  Mwv208ConstantBank ConstantBank;
+
+  /// PrivateArrays - Stack objects promoted to temp registers, keyed by
+  /// frame index. They take r0 to r<NumPrivateRegs-1>.
+  DenseMap<int, Mwv208PrivateArray> PrivateArrays;
+  unsigned NumPrivateRegs = 0;
+
 public:
   Mwv208MachineFunctionInfo()
       : GlobalBaseReg(0), VarArgsFrameOffset(0), SRetReturnReg(0),
@@ -54,6 +125,20 @@ public:
 
   void setLeafProc(bool rhs) { IsLeafProc = rhs; }
   bool isLeafProc() const { return IsLeafProc; }
+
+  Mwv208ConstantBank &getConstantBank() { return ConstantBank; }
+  const Mwv208ConstantBank &getConstantBank() const { return ConstantBank; }
+
+  /// Return the registers holding frame object \p FI, an array of
+  /// \p ObjectSize bytes accessed \p EltBytes at a time, placing it on first
+  /// use. Fails when the object is accessed with another element size, or
+  /// when it would leave less than half of the \p NumTempRegs temp registers
+  /// to the allocator.
+  std::optional<Mwv208PrivateArray> getPrivateArray(int FI,
+                                                    uint64_t ObjectSize,
+                                                    unsigned EltBytes,
+                                                    unsigned NumTempRegs);
+  unsigned getNumPrivateRegs() const { return NumPrivateRegs; }
 };
 } // namespace llvm
 
@@ -0,0 +1,135 @@
+//===-- Mwv208MachineScheduler.cpp - MWV208 scheduling strategy -----------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Texture samples are grouped into clauses and hoisted as early as register
+// pressure allows, see Mwv208SchedStrategy. After register allocation the
+// clauses are kept and the remaining instructions are ordered to hide ALU
+// latency, see Mwv208PostSchedStrategy. Run with -stats to see how many
+// clauses were formed, or -misched=mwv208 / -misched=default to compare the
+// strategy against the generic one.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Mwv208MachineScheduler.h"
+#include "Mwv208InstrInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Statistic.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "machine-scheduler"
+
+STATISTIC(NumSampleClauses, "Number of texture sample clauses formed");
+STATISTIC(NumClausedSamples, "Number of texture samples scheduled in clauses");
+
+static bool isSample(const SUnit *SU) {
+  return !SU->isBoundaryNode() && Mwv208InstrInfo::isSample(*SU->getInstr());
+}
+
+/// Whether \p SU reads the texel of a sample of the region.
+static bool readsSample(const SUnit *SU) {
+  return any_of(SU->Preds, [](const SDep &D) {
+    return D.getKind() == SDep::Data && isSample(D.getSUnit());
+  });
+}
+
+void Mwv208SchedStrategy::initialize(ScheduleDAGMI *DAG) {
+  GenericScheduler::initialize(DAG);
+  InClause = false;
+}
+
+void Mwv208SchedStrategy::initPolicy(MachineBasicBlock::iterator Begin,
+                                     MachineBasicBlock::iterator End,
+                                     unsigned NumRegionInstrs) {
+  GenericScheduler::initPolicy(Begin, End, NumRegionInstrs);
+  // Hoisting samples is only bounded by register pressure, which must be
+  // known even in small regions.
+  RegionPolicy.ShouldTrackPressure = true;
+  RegionPolicy.OnlyTopDown = true;
+  RegionPolicy.OnlyBottomUp = false;
+}
+
+bool Mwv208SchedStrategy::tryCandidate(SchedCandidate &Cand,
+                                       SchedCandidate &TryCand,
+                                       SchedBoundary *Zone) const {
+  if (!Cand.isValid()) {
+    TryCand.Reason = NodeOrder;
+    return true;
+  }
+
+  // A hoisted texel stays live across everything scheduled after it, so
+  // never hoist past the register limit.
+  if (DAG->isTrackingPressure()) {
+    if (tryPressure(TryCand.RPDelta.Excess, Cand.RPDelta.Excess, TryCand, Cand,
+                    RegExcess, TRI, DAG->MF))
+      return TryCand.Reason != NoCand;
+    if (tryPressure(TryCand.RPDelta.CriticalMax, Cand.RPDelta.CriticalMax,
+                    TryCand, Cand, RegCritical, TRI, DAG->MF))
+      return TryCand.Reason != NoCand;
+  }
+
+  // Issue the ready samples back to back, ...
+  if (tryGreater(isSample(TryCand.SU), isSample(Cand.SU), TryCand, Cand,
+                 Cluster))
+    return TryCand.Reason != NoCand;
+
+  // ... then the ALU work that does not wait for them.
+  if (tryLess(readsSample(TryCand.SU), readsSample(Cand.SU), TryCand, Cand,
+              Stall))
+    return TryCand.Reason != NoCand;
+
+  return GenericScheduler::tryCandidate(Cand, TryCand, Zone);
+}
+
+void Mwv208SchedStrategy::schedNode(SUnit *SU, bool IsTopNode) {
+  GenericScheduler::schedNode(SU, IsTopNode);
+  bool IsSample = isSample(SU);
+  if (IsSample) {
+    ++NumClausedSamples;
+    if (!InClause)
+      ++NumSampleClauses;
+  }
+  InClause = IsSample;
+}
+
+bool Mwv208PostSchedStrategy::tryCandidate(SchedCandidate &Cand,
+                                           SchedCandidate &TryCand) {
+  if (!Cand.isValid()) {
+    TryCand.Reason = NodeOrder;
+    return true;
+  }
+
+  // Register pressure no longer matters, the clauses formed before
+  // allocation are kept together ...
+  if (tryGreater(isSample(TryCand.SU), isSample(Cand.SU), TryCand, Cand,
+                 Cluster))
+    return TryCand.Reason != NoCand;
+
+  // ... and ALU work reading a texel still goes last.
+  if (tryLess(readsSample(TryCand.SU), readsSample(Cand.SU), TryCand, Cand,
+              Stall))
+    return TryCand.Reason != NoCand;
+
+  return PostGenericScheduler::tryCandidate(Cand, TryCand);
+}
+
+ScheduleDAGInstrs *llvm::createMwv208MachineScheduler(MachineSchedContext *C) {
+  ScheduleDAGMILive *DAG =
+      new ScheduleDAGMILive(C, std::make_unique<Mwv208SchedStrategy>(C));
+  DAG->addMutation(createCopyConstrainDAGMutation(DAG->TII, DAG->TRI));
+  return DAG;
+}
+
+ScheduleDAGInstrs *
+llvm::createMwv208PostMachineScheduler(MachineSchedContext *C) {
+  return new ScheduleDAGMI(C, std::make_unique<Mwv208PostSchedStrategy>(C),
+                           /*RemoveKillFlags=*/true);
+}
+
+static MachineSchedRegistry
+    Mwv208SchedRegistry("mwv208", "Clause texture samples at the region top",
+                        createMwv208MachineScheduler);
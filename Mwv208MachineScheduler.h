@@ -0,0 +1,63 @@
+//===-- Mwv208MachineScheduler.h - MWV208 scheduling strategy ---*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// The scheduling strategies of MWV208, which form clauses of texture samples
+// at the top of each region.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_MWV208_MWV208MACHINESCHEDULER_H
+#define LLVM_LIB_TARGET_MWV208_MWV208MACHINESCHEDULER_H
+
+#include "llvm/CodeGen/MachineScheduler.h"
+
+namespace llvm {
+
+/// A sample takes hundreds of cycles to return its texel, which only ALU
+/// work independent of it can hide. Regions are scheduled top-down: every
+/// ready sample is issued as soon as register pressure allows, back to back
+/// with the other ready samples, and ALU instructions reading a texel are
+/// kept behind those that do not. Otherwise this is the generic strategy.
+class Mwv208SchedStrategy : public GenericScheduler {
+  /// Whether the last instruction scheduled was a sample, i.e. a clause is
+  /// open.
+  bool InClause = false;
+
+public:
+  Mwv208SchedStrategy(const MachineSchedContext *C) : GenericScheduler(C) {}
+
+  void initialize(ScheduleDAGMI *DAG) override;
+  void initPolicy(MachineBasicBlock::iterator Begin,
+                  MachineBasicBlock::iterator End,
+                  unsigned NumRegionInstrs) override;
+  void schedNode(SUnit *SU, bool IsTopNode) override;
+
+protected:
+  bool tryCandidate(SchedCandidate &Cand, SchedCandidate &TryCand,
+                    SchedBoundary *Zone) const override;
+};
+
+/// The post-RA counterpart of Mwv208SchedStrategy. The core issues a single
+/// instruction per cycle, so after register allocation and scalar packing
+/// all that is left is keeping that slot busy: samples first, then the
+/// generic latency and resource heuristics of the scheduling model.
+class Mwv208PostSchedStrategy : public PostGenericScheduler {
+public:
+  Mwv208PostSchedStrategy(const MachineSchedContext *C)
+      : PostGenericScheduler(C) {}
+
+protected:
+  bool tryCandidate(SchedCandidate &Cand, SchedCandidate &TryCand) override;
+};
+
+ScheduleDAGInstrs *createMwv208MachineScheduler(MachineSchedContext *C);
+ScheduleDAGInstrs *createMwv208PostMachineScheduler(MachineSchedContext *C);
+
+} // end namespace llvm
+
+#endif // LLVM_LIB_TARGET_MWV208_MWV208MACHINESCHEDULER_H
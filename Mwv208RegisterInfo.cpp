@@ -13,6 +13,7 @@
 
 #include "Mwv208RegisterInfo.h"
 #include "Mwv208.h"
+#include "Mwv208MachineFunctionInfo.h"
 #include "Mwv208Subtarget.h"
 #include "llvm/ADT/BitVector.h"
 #include "llvm/CodeGen/MachineFrameInfo.h"
@@ -25,3 +26,48 @@ using namespace llvm;
 
 #define GET_REGINFO_TARGET_DESC
 #include "Mwv208GenRegisterInfo.inc"
+
+Mwv208RegisterInfo::Mwv208RegisterInfo() : Mwv208GenRegisterInfo(MWV208::r0) {}
+
+const MCPhysReg *
+Mwv208RegisterInfo::getCalleeSavedRegs(const MachineFunction *MF) const {
+  // Kernels are not called, nothing is preserved.
+  static const MCPhysReg CalleeSavedRegs[] = {0};
+  return CalleeSavedRegs;
+}
+
+BitVector Mwv208RegisterInfo::getReservedRegs(const MachineFunction &MF) const {
+  BitVector Reserved(getNumRegs());
+  unsigned NumTempRegs = MF.getSubtarget<Mwv208Subtarget>().getNumTempRegs();
+  const TargetRegisterClass &RC = MWV208::TempRegClassRegClass;
+  for (unsigned I = NumTempRegs, E = RC.getNumRegs(); I < E; ++I)
+    for (MCPhysReg Reg : subregs_inclusive(RC.getRegister(I)))
+      Reserved.set(Reg);
+
+  // Private arrays indexed through a0 sit at the bottom of the temp file.
+  unsigned NumPrivateRegs =
+      MF.getInfo<Mwv208MachineFunctionInfo>()->getNumPrivateRegs();
+  for (unsigned I = 0; I != NumPrivateRegs; ++I)
+    for (MCPhysReg Reg : subregs_inclusive(RC.getRegister(I)))
+      Reserved.set(Reg);
+
+  // a0 is only ever written by the expansion of the private array pseudos.
+  for (MCPhysReg Reg : MWV208::AddrRegRegClass)
+    Reserved.set(Reg);
+
+  // The constant bank is written by the driver and only ever read.
+  for (MCPhysReg CReg : MWV208::ConstRegClassRegClass)
+    for (MCPhysReg Reg : subregs_inclusive(CReg))
+      Reserved.set(Reg);
+  return Reserved;
+}
+
+bool Mwv208RegisterInfo::eliminateFrameIndex(MachineBasicBlock::iterator II,
+                                             int SPAdj, unsigned FIOperandNum,
+                                             RegScavenger *RS) const {
+  report_fatal_error("MWV208 has no stack; frame indices are unsupported");
+}
+
+Register Mwv208RegisterInfo::getFrameRegister(const MachineFunction &MF) const {
+  return MWV208::NoRegister;
+}
@@ -14,6 +14,7 @@
 #ifndef LLVM_LIB_TARGET_MWV208_MWV208REGISTERINFO_H
 #define LLVM_LIB_TARGET_MWV208_MWV208REGISTERINFO_H
 
+#include "MCTargetDesc/Mwv208MCTargetDesc.h"
 #include "llvm/CodeGen/TargetRegisterInfo.h"
 
 #define GET_REGINFO_HEADER
@@ -22,8 +23,33 @@
 namespace llvm {
 struct Mwv208RegisterInfo : public Mwv208GenRegisterInfo {
   Mwv208RegisterInfo();
+
+  /// Code generation interface.
+  const MCPhysReg *getCalleeSavedRegs(const MachineFunction *MF) const override;
+
+  /// getReservedRegs - Temp registers beyond the register file of the
+  /// subtarget and the constant registers, with their components, are never
+  /// allocated.
+  BitVector getReservedRegs(const MachineFunction &MF) const override;
+
+  bool eliminateFrameIndex(MachineBasicBlock::iterator II, int SPAdj,
+                           unsigned FIOperandNum,
+                           RegScavenger *RS = nullptr) const override;
+
+  Register getFrameRegister(const MachineFunction &MF) const override;
 };
 
+namespace MWV208 {
+/// Return the sub-register index of component \p Lane (x=0 ... w=3) of a
+/// 128-bit temp register.
+inline unsigned getComponentSubReg(unsigned Lane) {
+  static const unsigned SubRegs[] = {MWV208::subx, MWV208::suby, MWV208::subz,
+                                     MWV208::subw};
+  assert(Lane < 4 && "Invalid component");
+  return SubRegs[Lane];
+}
+} // end namespace MWV208
+
 } // end namespace llvm
 
 #endif
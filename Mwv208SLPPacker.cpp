@@ -0,0 +1,320 @@
+//===-- Mwv208SLPPacker.cpp - Pack scalar ALU instructions into vec4 ------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Every instruction computes four lanes, but a scalar one only writes one of
+// them. After register allocation, independent scalar instructions of the
+// same kind whose destinations are different components of one register are
+// fused into the vec4 form of the instruction:
+//
+//   add.s32 r2.x, r0.y, r1.x          add.s32 r2, r0.yzzz, r1.xxwx
+//   add.s32 r2.y, r0.z, r1.x    =>
+//   add.s32 r2.z, r0.z, r1.w
+//
+// Each source of the vec4 form is a single register read through a swizzle,
+// so the n-th sources of the scalars must be components of one register.
+// The vec4 form writes every lane of its destination, so the lanes no
+// scalar writes must be dead.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MCTargetDesc/Mwv208BaseInfo.h"
+#include "Mwv208.h"
+#include "Mwv208Subtarget.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/LiveRegUnits.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/CommandLine.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "mwv208-slp-packer"
+#define PASS_NAME "MWV208 scalar to vec4 packing"
+
+STATISTIC(NumPacked, "Number of vec4 instructions formed from scalars");
+STATISTIC(NumScalarsPacked, "Number of scalar instructions packed");
+
+static cl::opt<unsigned>
+    PackWindow("mwv208-slp-pack-window", cl::Hidden, cl::init(16),
+               cl::desc("Number of instructions searched for scalars to "
+                        "pack with each scalar instruction"));
+
+namespace {
+/// A scalar instruction and where it reads and writes, as (register, lane).
+struct LaneOp {
+  MachineInstr *MI;
+  MCRegister Dst;
+  unsigned DstLane;
+  /// Parent register and lane of each register source, in operand order.
+  SmallVector<std::pair<MCRegister, unsigned>, 3> Srcs;
+};
+
+class Mwv208SLPPacker : public MachineFunctionPass {
+  const TargetInstrInfo *TII = nullptr;
+  const TargetRegisterInfo *TRI = nullptr;
+  const MachineRegisterInfo *MRI = nullptr;
+
+  /// The (parent register, lane) pair of component register \p Reg.
+  std::pair<MCRegister, unsigned> getLane(MCRegister Reg) const;
+  bool analyze(MachineInstr &MI, LaneOp &Op) const;
+  bool isCompatible(const LaneOp &Leader, const LaneOp &Op) const;
+  bool conflicts(const MachineInstr &MI, ArrayRef<LaneOp> Group) const;
+  bool deadElsewhere(MachineBasicBlock &MBB, ArrayRef<LaneOp> Group) const;
+  MachineInstr *pack(MachineBasicBlock &MBB, ArrayRef<LaneOp> Group) const;
+  bool packBlock(MachineBasicBlock &MBB);
+
+public:
+  static char ID;
+  Mwv208SLPPacker() : MachineFunctionPass(ID) {}
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return PASS_NAME; }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesCFG();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+  MachineFunctionProperties getRequiredProperties() const override {
+    return MachineFunctionProperties().set(
+        MachineFunctionProperties::Property::NoVRegs);
+  }
+};
+} // end anonymous namespace
+
+char Mwv208SLPPacker::ID = 0;
+
+INITIALIZE_PASS(Mwv208SLPPacker, DEBUG_TYPE, PASS_NAME, false, false)
+
+// Temp and constant components alike, see SrcComp32.
+std::pair<MCRegister, unsigned>
+Mwv208SLPPacker::getLane(MCRegister Reg) const {
+  unsigned Lane = MWV208::getComponentLane(TRI->getEncodingValue(Reg));
+  return {TRI->getMatchingSuperReg(Reg, MWV208::getComponentSubReg(Lane),
+                                   &MWV208::SrcRegClassRegClass),
+          Lane};
+}
+
+// Only unpredicated scalar forms with a vec4 counterpart qualify, and only
+// when no source is addressed relative to a0, whose lanes are shared.
+bool Mwv208SLPPacker::analyze(MachineInstr &MI, LaneOp &Op) const {
+  if (MWV208::getVectorOpcode(MI.getOpcode()) < 0 || TII->isPredicated(MI) ||
+      MI.isBundled() || MI.getNumOperands() != MI.getDesc().getNumOperands())
+    return false;
+
+  Op.MI = &MI;
+  std::tie(Op.Dst, Op.DstLane) = getLane(MI.getOperand(0).getReg());
+  Op.Srcs.clear();
+  ArrayRef<MCOperandInfo> Info = MI.getDesc().operands();
+  for (unsigned I = 1, E = MI.getNumOperands(); I != E; ++I) {
+    const MachineOperand &MO = MI.getOperand(I);
+    if (!MO.isReg() || Info[I].isPredicate())
+      continue;
+    // (reg, swizzle, mod), see Mwv208SrcOperand.
+    if (MWV208::getSrcModRel(MI.getOperand(I + 2).getImm()) !=
+        MWV208::REL_NONE)
+      return false;
+    Op.Srcs.push_back(getLane(MO.getReg()));
+    I += 2;
+  }
+  return true;
+}
+
+// Same instruction, modifiers, immediates and source registers, and a lane
+// of the destination no other scalar of the group writes.
+bool Mwv208SLPPacker::isCompatible(const LaneOp &Leader,
+                                   const LaneOp &Op) const {
+  const MachineInstr &A = *Leader.MI, &B = *Op.MI;
+  if (A.getOpcode() != B.getOpcode() || Leader.Dst != Op.Dst ||
+      Leader.DstLane == Op.DstLane)
+    return false;
+  for (auto [SA, SB] : zip(Leader.Srcs, Op.Srcs))
+    if (SA.first != SB.first)
+      return false;
+
+  ArrayRef<MCOperandInfo> Info = A.getDesc().operands();
+  for (unsigned I = 1, E = A.getNumOperands(); I != E; ++I) {
+    const MachineOperand &MA = A.getOperand(I), &MB = B.getOperand(I);
+    if (MA.isReg() && !Info[I].isPredicate()) {
+      // The swizzle of a scalar source is implied by its lane, only the
+      // modifiers have to agree.
+      if (A.getOperand(I + 2).getImm() != B.getOperand(I + 2).getImm())
+        return false;
+      I += 2;
+      continue;
+    }
+    if (!MA.isIdenticalTo(MB))
+      return false;
+  }
+  return true;
+}
+
+// The scalars of the group are sunk to the last one. That is only correct
+// when nothing in between reads or writes what they write, or writes what
+// they read. Kills of their sources in between are cleared, see pack.
+bool Mwv208SLPPacker::conflicts(const MachineInstr &MI,
+                                ArrayRef<LaneOp> Group) const {
+  for (const LaneOp &Op : Group) {
+    const MachineOperand &Dst = Op.MI->getOperand(0);
+    if (MI.readsRegister(Dst.getReg(), TRI) ||
+        MI.modifiesRegister(Dst.getReg(), TRI))
+      return true;
+    for (const MachineOperand &MO : Op.MI->uses())
+      if (MO.isReg() && MO.getReg() && MI.modifiesRegister(MO.getReg(), TRI))
+        return true;
+  }
+  return false;
+}
+
+// Whether the lanes of the destination the group does not write are dead
+// after its last scalar, which is where the vec4 form goes.
+bool Mwv208SLPPacker::deadElsewhere(MachineBasicBlock &MBB,
+                                    ArrayRef<LaneOp> Group) const {
+  unsigned Lanes = 0;
+  for (const LaneOp &Op : Group)
+    Lanes |= 1u << Op.DstLane;
+
+  LiveRegUnits LiveUnits(*TRI);
+  LiveUnits.addLiveOuts(MBB);
+  for (MachineInstr &MI : llvm::reverse(MBB)) {
+    if (&MI == Group.back().MI)
+      break;
+    LiveUnits.stepBackward(MI);
+  }
+
+  MCRegister Dst = Group.front().Dst;
+  for (unsigned Lane = 0; Lane != 4; ++Lane) {
+    if (Lanes & (1u << Lane))
+      continue;
+    MCRegister Comp = TRI->getSubReg(Dst, MWV208::getComponentSubReg(Lane));
+    // Reserved components hold private arrays and are not tracked.
+    if (MRI->isReserved(Comp) || !LiveUnits.available(Comp))
+      return false;
+  }
+  return true;
+}
+
+MachineInstr *Mwv208SLPPacker::pack(MachineBasicBlock &MBB,
+                                    ArrayRef<LaneOp> Group) const {
+  const MachineInstr &Leader = *Group.front().MI;
+  MachineInstr &Last = *Group.back().MI;
+  MachineInstrBuilder MIB =
+      BuildMI(MBB, Last, Last.getDebugLoc(),
+              TII->get(MWV208::getVectorOpcode(Leader.getOpcode())),
+              Group.front().Dst);
+
+  ArrayRef<MCOperandInfo> Info = Leader.getDesc().operands();
+  unsigned SrcIdx = 0;
+  for (unsigned I = 1, E = Leader.getNumOperands(); I != E; ++I) {
+    const MachineOperand &MO = Leader.getOperand(I);
+    if (!MO.isReg() || Info[I].isPredicate()) {
+      MIB.add(MO);
+      continue;
+    }
+    // Lane n of the source reads the component the scalar writing lane n
+    // read. Lanes no scalar writes read x.
+    unsigned Swz = MWV208::Swizzle::XXXX;
+    for (const LaneOp &Op : Group)
+      Swz = MWV208::Swizzle::setComponent(Swz, Op.DstLane,
+                                          Op.Srcs[SrcIdx].second);
+    MIB.addReg(Group.front().Srcs[SrcIdx].first)
+        .addImm(Swz)
+        .add(Leader.getOperand(I + 2));
+    ++SrcIdx;
+    I += 2;
+  }
+
+  // The sources are now read at the last scalar. A kill of one of them by
+  // an instruction in between is no longer one.
+  for (MachineInstr &MI :
+       make_range(std::next(MachineBasicBlock::iterator(Group.front().MI)),
+                  MachineBasicBlock::iterator(Last))) {
+    if (any_of(Group, [&](const LaneOp &Op) { return Op.MI == &MI; }))
+      continue;
+    for (const LaneOp &Op : Group)
+      for (const MachineOperand &MO : Op.MI->uses())
+        if (MO.isReg() && MO.getReg())
+          MI.clearRegisterKills(MO.getReg(), TRI);
+  }
+
+  for (const LaneOp &Op : Group)
+    Op.MI->eraseFromParent();
+  ++NumPacked;
+  NumScalarsPacked += Group.size();
+  return MIB;
+}
+
+bool Mwv208SLPPacker::packBlock(MachineBasicBlock &MBB) {
+  MachineFunction &MF = *MBB.getParent();
+  bool Changed = false;
+  for (MachineBasicBlock::iterator I = MBB.begin(); I != MBB.end();) {
+    SmallVector<LaneOp, 4> Group(1);
+    if (!analyze(*I, Group[0])) {
+      ++I;
+      continue;
+    }
+
+    // Grow the group forward, greedily, until a lane is left or something
+    // depends on the scalars collected so far.
+    unsigned Scanned = 0;
+    for (MachineBasicBlock::iterator J = std::next(I);
+         J != MBB.end() && Group.size() != 4 && Scanned != PackWindow; ++J) {
+      if (J->isDebugInstr())
+        continue;
+      ++Scanned;
+      if (TII->isSchedulingBoundary(*J, &MBB, MF))
+        break;
+      LaneOp Op;
+      if (analyze(*J, Op) && isCompatible(Group.front(), Op) &&
+          none_of(Group,
+                  [&](const LaneOp &G) { return G.DstLane == Op.DstLane; }) &&
+          !conflicts(*J, Group)) {
+        Group.push_back(std::move(Op));
+        continue;
+      }
+      if (conflicts(*J, Group))
+        break;
+    }
+
+    if (Group.size() < 2 || !deadElsewhere(MBB, Group)) {
+      ++I;
+      continue;
+    }
+
+    // Resume after the leader, skipping the scalars that are about to go.
+    MachineBasicBlock::iterator Next = std::next(I);
+    // The instructions in between may still form a group of their own.
+    while (Next != MBB.end() &&
+           any_of(Group, [&](const LaneOp &Op) { return Op.MI == &*Next; }))
+      ++Next;
+    pack(MBB, Group);
+    I = Next;
+    Changed = true;
+  }
+  return Changed;
+}
+
+bool Mwv208SLPPacker::runOnMachineFunction(MachineFunction &MF) {
+  if (skipFunction(MF.getFunction()))
+    return false;
+
+  TII = MF.getSubtarget().getInstrInfo();
+  TRI = MF.getSubtarget().getRegisterInfo();
+  MRI = &MF.getRegInfo();
+
+  bool Changed = false;
+  for (MachineBasicBlock &MBB : MF)
+    Changed |= packBlock(MBB);
+  return Changed;
+}
+
+FunctionPass *llvm::createMwv208SLPPackerPass() {
+  return new Mwv208SLPPacker();
+}
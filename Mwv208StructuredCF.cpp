@@ -0,0 +1,278 @@
+//===-- Mwv208StructuredCF.cpp - Lower divergent branches to masks --------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Conditional branches whose condition differs between the threads of a
+// warp are selected as BRCOND_DIV. Early if-conversion turns the short
+// regions into sels first. StructurizeCFG has brought every other divergent
+// region into one of two shapes, see Mwv208PassConfig::addPreISel:
+//
+//   - the latch of a loop with a single exit, lowered to a WHILE at the end
+//     of the preheader and an ENDWHILE_s in the latch;
+//   - the head of an if-then region, whose join post-dominates the other
+//     successor, lowered to an IF_s in the head and an ENDIF at the join.
+//
+// The join of an if may also be reached from outside of the region, when
+// regions share their exit. Only the edges leaving the region may pop the
+// mask, so they are moved to a new block holding the ENDIF.
+//
+//===----------------------------------------------------------------------===//
+
+#include "MCTargetDesc/Mwv208BaseInfo.h"
+#include "Mwv208.h"
+#include "Mwv208Subtarget.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/CodeGen/MachineDominators.h"
+#include "llvm/CodeGen/MachineFunctionPass.h"
+#include "llvm/CodeGen/MachineInstrBuilder.h"
+#include "llvm/CodeGen/MachineLoopInfo.h"
+#include "llvm/CodeGen/MachinePostDominators.h"
+#include "llvm/CodeGen/MachineRegisterInfo.h"
+#include "llvm/Support/ErrorHandling.h"
+using namespace llvm;
+
+#define DEBUG_TYPE "mwv208-structured-cf"
+#define PASS_NAME "MWV208 structured control flow"
+
+STATISTIC(NumIfs, "Number of divergent branches lowered to if/endif");
+STATISTIC(NumWhiles, "Number of divergent loops lowered to while/endwhile");
+STATISTIC(NumSplitJoins, "Number of joins split to hold an endif");
+
+namespace {
+class Mwv208StructuredCF : public MachineFunctionPass {
+  const TargetInstrInfo *TII = nullptr;
+  MachineRegisterInfo *MRI = nullptr;
+  MachineDominatorTree *MDT = nullptr;
+
+  /// Blocks created to hold an ENDIF, mapped to the head of their if. They
+  /// are not in the dominator tree.
+  DenseMap<MachineBasicBlock *, MachineBasicBlock *> NewJoins;
+
+public:
+  static char ID;
+  Mwv208StructuredCF() : MachineFunctionPass(ID) {}
+
+  bool runOnMachineFunction(MachineFunction &MF) override;
+
+  StringRef getPassName() const override { return PASS_NAME; }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<MachineDominatorTreeWrapperPass>();
+    AU.addRequired<MachinePostDominatorTreeWrapperPass>();
+    AU.addRequired<MachineLoopInfoWrapperPass>();
+    MachineFunctionPass::getAnalysisUsage(AU);
+  }
+
+private:
+  bool dominates(MachineBasicBlock *A, MachineBasicBlock *B) const;
+  void replaceBranch(MachineInstr &Br, unsigned Opc, unsigned CC,
+                     MachineBasicBlock *Target, MachineBasicBlock *Next);
+  void insertEndIf(MachineBasicBlock *Head, MachineBasicBlock *Join);
+};
+} // end anonymous namespace
+
+char Mwv208StructuredCF::ID = 0;
+
+INITIALIZE_PASS_BEGIN(Mwv208StructuredCF, DEBUG_TYPE, PASS_NAME, false, false)
+INITIALIZE_PASS_DEPENDENCY(MachineDominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(MachinePostDominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(MachineLoopInfoWrapperPass)
+INITIALIZE_PASS_END(Mwv208StructuredCF, DEBUG_TYPE, PASS_NAME, false, false)
+
+static MachineInstr *findDivergentBranch(MachineBasicBlock &MBB) {
+  for (MachineInstr &MI : MBB.terminators())
+    if (MI.getOpcode() == MWV208::BRCOND_DIV)
+      return &MI;
+  return nullptr;
+}
+
+static bool fallsThroughTo(MachineBasicBlock &MBB, MachineBasicBlock *Succ) {
+  return MBB.isLayoutSuccessor(Succ) && MBB.isSuccessor(Succ) &&
+         (MBB.empty() || !MBB.back().isBarrier());
+}
+
+bool Mwv208StructuredCF::dominates(MachineBasicBlock *A,
+                                   MachineBasicBlock *B) const {
+  // A new join is only entered from inside of its if.
+  for (auto It = NewJoins.find(B); It != NewJoins.end(); It = NewJoins.find(B))
+    B = It->second;
+  return MDT->dominates(A, B);
+}
+
+// Replace the BRCOND_DIV and the branch that may follow it. The mask
+// instructions fall through when some lane carries on, so Next must follow.
+void Mwv208StructuredCF::replaceBranch(MachineInstr &Br, unsigned Opc,
+                                       unsigned CC, MachineBasicBlock *Target,
+                                       MachineBasicBlock *Next) {
+  MachineBasicBlock &MBB = *Br.getParent();
+  DebugLoc DL = Br.getDebugLoc();
+  // BRCOND_DIV operands are the (reg, swizzle, mod) of the condition, the
+  // condition code and the target.
+  BuildMI(MBB, Br, DL, TII->get(Opc))
+      .add(Br.getOperand(0))
+      .add(Br.getOperand(1))
+      .add(Br.getOperand(2))
+      .addImm(CC)
+      .addMBB(Target);
+  MBB.erase(Br.getIterator(), MBB.end());
+  if (!MBB.isLayoutSuccessor(Next))
+    BuildMI(&MBB, DL, TII->get(MWV208::BR)).addMBB(Next);
+}
+
+void Mwv208StructuredCF::insertEndIf(MachineBasicBlock *Head,
+                                     MachineBasicBlock *Join) {
+  SmallVector<MachineBasicBlock *, 4> Inner;
+  bool FromOutside = false;
+  for (MachineBasicBlock *Pred : Join->predecessors()) {
+    if (dominates(Head, Pred))
+      Inner.push_back(Pred);
+    else
+      FromOutside = true;
+  }
+
+  if (!FromOutside) {
+    BuildMI(*Join, Join->getFirstNonPHI(), DebugLoc(),
+            TII->get(MWV208::ENDIF));
+    return;
+  }
+
+  // Route the edges from inside of the if through a new block right before
+  // the join. A block that fell into the join from outside now jumps over it.
+  MachineFunction &MF = *Join->getParent();
+  MachineBasicBlock *NewJoin =
+      MF.CreateMachineBasicBlock(Join->getBasicBlock());
+  if (Join != &MF.front()) {
+    MachineBasicBlock &LayoutPred = *std::prev(Join->getIterator());
+    if (fallsThroughTo(LayoutPred, Join) && !is_contained(Inner, &LayoutPred))
+      BuildMI(&LayoutPred, DebugLoc(), TII->get(MWV208::BR)).addMBB(Join);
+  }
+  MF.insert(Join->getIterator(), NewJoin);
+
+  // Values from inside of the if are merged in the new block first.
+  for (MachineInstr &Phi : Join->phis()) {
+    SmallVector<unsigned, 4> InnerOps;
+    for (unsigned I = 1, E = Phi.getNumOperands(); I != E; I += 2)
+      if (is_contained(Inner, Phi.getOperand(I + 1).getMBB()))
+        InnerOps.push_back(I);
+
+    if (InnerOps.size() == 1) {
+      Phi.getOperand(InnerOps.front() + 1).setMBB(NewJoin);
+      continue;
+    }
+
+    Register Reg = MRI->createVirtualRegister(
+        MRI->getRegClass(Phi.getOperand(0).getReg()));
+    MachineInstrBuilder NewPhi =
+        BuildMI(*NewJoin, NewJoin->end(), Phi.getDebugLoc(),
+                TII->get(TargetOpcode::PHI), Reg);
+    for (unsigned I : InnerOps)
+      NewPhi.add(Phi.getOperand(I)).add(Phi.getOperand(I + 1));
+    for (unsigned I : llvm::reverse(InnerOps)) {
+      Phi.removeOperand(I + 1);
+      Phi.removeOperand(I);
+    }
+    Phi.addOperand(MachineOperand::CreateReg(Reg, /*isDef=*/false));
+    Phi.addOperand(MachineOperand::CreateMBB(NewJoin));
+  }
+
+  for (MachineBasicBlock *Pred : Inner)
+    Pred->ReplaceUsesOfBlockWith(Join, NewJoin);
+  NewJoin->addSuccessor(Join);
+  BuildMI(*NewJoin, NewJoin->end(), DebugLoc(), TII->get(MWV208::ENDIF));
+  NewJoins[NewJoin] = Head;
+  ++NumSplitJoins;
+}
+
+bool Mwv208StructuredCF::runOnMachineFunction(MachineFunction &MF) {
+  TII = MF.getSubtarget().getInstrInfo();
+  MRI = &MF.getRegInfo();
+  MDT = &getAnalysis<MachineDominatorTreeWrapperPass>().getDomTree();
+  MachinePostDominatorTree &MPDT =
+      getAnalysis<MachinePostDominatorTreeWrapperPass>().getPostDomTree();
+  MachineLoopInfo &MLI = getAnalysis<MachineLoopInfoWrapperPass>().getLI();
+  NewJoins.clear();
+
+  // Inner regions are dominated by the head of the enclosing one, visit
+  // them first so that their ENDIF comes first at a shared join.
+  SmallVector<MachineInstr *, 8> Branches;
+  for (MachineDomTreeNode *N : post_order(MDT->getRootNode()))
+    if (MachineInstr *Br = findDivergentBranch(*N->getBlock()))
+      Branches.push_back(Br);
+  if (Branches.empty())
+    return false;
+
+  // Replacing the branches keeps the CFG as it is, only the joins are split
+  // afterwards.
+  SmallVector<std::pair<MachineBasicBlock *, MachineBasicBlock *>, 8> Ifs;
+  for (MachineInstr *Br : Branches) {
+    MachineBasicBlock *Head = Br->getParent();
+    MachineBasicBlock *TrueBB = Br->getOperand(4).getMBB();
+    MachineBasicBlock *FalseBB = nullptr;
+    for (MachineBasicBlock *Succ : Head->successors())
+      if (Succ != TrueBB)
+        FalseBB = Succ;
+    auto CC = static_cast<MWV208::CondCode>(Br->getOperand(3).getImm());
+
+    // Both ways lead to the same block, the condition does not matter.
+    if (!FalseBB) {
+      DebugLoc DL = Br->getDebugLoc();
+      Head->erase(Br->getIterator(), Head->end());
+      if (!Head->isLayoutSuccessor(TrueBB))
+        BuildMI(Head, DL, TII->get(MWV208::BR)).addMBB(TrueBB);
+      continue;
+    }
+
+    // The loop back edge: lanes leave the loop where it is not taken.
+    MachineLoop *L = MLI.getLoopFor(Head);
+    if (L && (TrueBB == L->getHeader() || FalseBB == L->getHeader())) {
+      bool StayOnTrue = TrueBB == L->getHeader();
+      MachineBasicBlock *Exit = StayOnTrue ? FalseBB : TrueBB;
+      MachineBasicBlock *Preheader = L->getLoopPreheader();
+      if (L->contains(Exit) || !Preheader)
+        report_fatal_error("Divergent loop is not structured");
+
+      BuildMI(*Preheader, Preheader->getFirstTerminator(), Br->getDebugLoc(),
+              TII->get(MWV208::WHILE));
+      replaceBranch(*Br, MWV208::ENDWHILE_s,
+                    StayOnTrue ? MWV208::getOppositeCondition(CC) : CC,
+                    L->getHeader(), Exit);
+      ++NumWhiles;
+      continue;
+    }
+
+    // An if-then region: lanes for which the body is not taken wait at the
+    // join, which post-dominates the body.
+    MachineBasicBlock *Join, *Body;
+    if (MPDT.dominates(FalseBB, TrueBB)) {
+      Join = FalseBB;
+      Body = TrueBB;
+    } else if (MPDT.dominates(TrueBB, FalseBB)) {
+      Join = TrueBB;
+      Body = FalseBB;
+      CC = MWV208::getOppositeCondition(CC);
+    } else {
+      report_fatal_error("Divergent branch is not structured");
+    }
+    if (L && !L->contains(Join))
+      report_fatal_error("Divergent branch leaves its loop");
+
+    replaceBranch(*Br, MWV208::IF_s, CC, Join, Body);
+    Ifs.push_back({Head, Join});
+    ++NumIfs;
+  }
+
+  for (auto [Head, Join] : Ifs)
+    insertEndIf(Head, Join);
+  return true;
+}
+
+FunctionPass *llvm::createMwv208StructuredCFPass() {
+  return new Mwv208StructuredCF();
+}
@@ -35,6 +35,9 @@ class Mwv208Subtarget : public TargetSubtargetInfo {
   Triple TargetTriple;
   virtual void anchor();
 
+  /// Number of allocatable temp registers, set by the temp-regs-N features.
+  unsigned NumTempRegs = 32;
+
 #define GET_SUBTARGETINFO_MACRO(ATTRIBUTE, DEFAULT, GETTER)                    \
   bool ATTRIBUTE = DEFAULT;
 #include "Mwv208GenSubtargetInfo.inc"
@@ -62,6 +65,13 @@ public:
 
   bool enableMachineScheduler() const override;
 
+  /// Components of a temp register are written independently through the
+  /// destination write mask, so track liveness per component.
+  bool enableSubRegLiveness() const override { return true; }
+
+  /// Short diamonds become sel, see Mwv208InstrInfo::canInsertSelect.
+  bool enableEarlyIfConversion() const override { return true; }
+
 #define GET_SUBTARGETINFO_MACRO(ATTRIBUTE, DEFAULT, GETTER)                    \
   bool GETTER() const { return ATTRIBUTE; }
 #include "Mwv208GenSubtargetInfo.inc"
@@ -74,6 +84,8 @@ public:
                                                    StringRef FS);
 
   bool isTargetLinux() const { return TargetTriple.isOSLinux(); }
+
+  unsigned getNumTempRegs() const { return NumTempRegs; }
 };
 
 } // end namespace llvm
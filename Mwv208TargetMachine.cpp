@@ -13,11 +13,15 @@
 #include "Mwv208TargetMachine.h"
 #include "Mwv208.h"
 #include "Mwv208MachineFunctionInfo.h"
+#include "Mwv208MachineScheduler.h"
 #include "Mwv208TargetObjectFile.h"
+#include "Mwv208TargetTransformInfo.h"
 #include "TargetInfo/Mwv208TargetInfo.h"
 #include "llvm/CodeGen/Passes.h"
 #include "llvm/CodeGen/TargetPassConfig.h"
 #include "llvm/MC/TargetRegistry.h"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/Transforms/Utils.h"
 #include <optional>
 using namespace llvm;
 
@@ -27,6 +31,9 @@ extern "C" LLVM_EXTERNAL_VISIBILITY void LLVMInitializeMwv208Target() {
 
   PassRegistry &PR = *PassRegistry::getPassRegistry();
   initializeMwv208DAGToDAGISelLegacyPass(PR);
+  initializeMwv208HardwareLoopsPass(PR);
+  initializeMwv208SLPPackerPass(PR);
+  initializeMwv208StructuredCFPass(PR);
 }
 
 static std::string computeDataLayout(const Triple &T, bool is64Bit) {
@@ -90,18 +97,26 @@ Mwv208TargetMachine::Mwv208TargetMachine(const Target &T, const Triple &TT,
 
 Mwv208TargetMachine::~Mwv208TargetMachine() = default;
 
-const TargetSubtargetInfo *
+const Mwv208Subtarget *
 Mwv208TargetMachine::getSubtargetImpl(const Function &F) const {
-  std::string CPU = "v8";
-  std::string FS = "";
+  // -mcpu picks the scheduling model, see Mwv208Schedule.td.
+  std::string CPU =
+      getTargetCPU().empty() ? "generic" : getTargetCPU().str();
+  // -mattr, e.g. the temp register file size.
+  std::string FS = getTargetFeatureString().str();
 
   if (!DefaultSubtarget) {
     DefaultSubtarget =
-        std::make_unique<TargetSubtargetInfo>(CPU, CPU, FS, *this, false);
+        std::make_unique<Mwv208Subtarget>(CPU, CPU, FS, *this, false);
   }
   return DefaultSubtarget.get();
 }
 
+TargetTransformInfo
+Mwv208TargetMachine::getTargetTransformInfo(const Function &F) const {
+  return TargetTransformInfo(Mwv208TTIImpl(this, F));
+}
+
 MachineFunctionInfo *Mwv208TargetMachine::createMachineFunctionInfo(
     BumpPtrAllocator &Allocator, const Function &F,
     const TargetSubtargetInfo *STI) const {
@@ -114,14 +129,30 @@ namespace {
 class Mwv208PassConfig : public TargetPassConfig {
 public:
   Mwv208PassConfig(Mwv208TargetMachine &TM, PassManagerBase &PM)
-      : TargetPassConfig(TM, PM) {}
+      : TargetPassConfig(TM, PM) {
+    // The SLP packer and if-conversion change the instructions after the
+    // pre-RA scheduler ran, reschedule them with the machine model.
+    substitutePass(&PostRASchedulerID, &PostMachineSchedulerID);
+  }
 
   Mwv208TargetMachine &getMwv208TargetMachine() const {
     return getTM<Mwv208TargetMachine>();
   }
 
+  ScheduleDAGInstrs *
+  createMachineScheduler(MachineSchedContext *C) const override {
+    return createMwv208MachineScheduler(C);
+  }
+
+  ScheduleDAGInstrs *
+  createPostMachineScheduler(MachineSchedContext *C) const override {
+    return createMwv208PostMachineScheduler(C);
+  }
+
   void addIRPasses() override;
+  bool addPreISel() override;
   bool addInstSelector() override;
+  void addPreSched2() override;
   void addPreEmitPass() override;
 };
 } // namespace
@@ -134,14 +165,49 @@ void Mwv208PassConfig::addIRPasses() {
   addPass(createAtomicExpandLegacyPass());
 
   TargetPassConfig::addIRPasses();
+
+  // Counted loops become LOOP/ENDLOOP, see Mwv208TTIImpl.
+  if (TM->getOptLevel() != CodeGenOptLevel::None)
+    addPass(createHardwareLoopsLegacyPass());
+}
+
+// Divergent branches can only be executed as if/endif and while/endwhile
+// mask regions. Bring the CFG into that shape after CodeGenPrepare, which
+// would otherwise fold the flow blocks away again. Regions whose branches
+// are all uniform keep their plain branches.
+bool Mwv208PassConfig::addPreISel() {
+  addPass(createLowerSwitchPass());
+  addPass(createFixIrreduciblePass());
+  addPass(createUnifyLoopExitsPass());
+  addPass(createStructurizeCFGPass(/*SkipUniformRegions=*/true));
+  return false;
 }
 
+// Early if-conversion runs while divergent branches are still BRCOND_DIV,
+// so that short divergent regions become sels instead of mask regions.
 bool Mwv208PassConfig::addInstSelector() {
   addPass(createMwv208ISelDag(getMwv208TargetMachine()));
+  if (getOptLevel() != CodeGenOptLevel::None)
+    addPass(&EarlyIfConverterLegacyID);
+  addPass(createMwv208StructuredCFPass());
   return false;
 }
 
-void Mwv208PassConfig::addPreEmitPass() {}
+// Blocks early if-conversion could not speculate are predicated through
+// CONDITION_CODE instead, see Mwv208InstrInfo::PredicateInstruction.
+void Mwv208PassConfig::addPreSched2() {
+  if (getOptLevel() == CodeGenOptLevel::None)
+    return;
+  // Before if-conversion, which predicates the scalars the packer skips.
+  addPass(createMwv208SLPPackerPass());
+  addPass(&IfConverterID);
+}
+
+void Mwv208PassConfig::addPreEmitPass() {
+  addPass(createMwv208HardwareLoopsPass());
+  // Last, so that the distances it measures are final.
+  addPass(&PostRAHazardRecognizerID);
+}
 
 void Mwv208V8TargetMachine::anchor() {}
 
@@ -37,7 +37,7 @@ public:
                       bool JIT, bool is64bit);
   ~Mwv208TargetMachine() override;
 
-  const TargetSubtargetInfo *getSubtargetImpl(const Function &F) const override;
+  const Mwv208Subtarget *getSubtargetImpl(const Function &F) const override;
 
   // Pass Pipeline Configuration
   TargetPassConfig *createPassConfig(PassManagerBase &PM) override;
@@ -45,6 +45,8 @@ public:
     return TLOF.get();
   }
 
+  TargetTransformInfo getTargetTransformInfo(const Function &F) const override;
+
   MachineFunctionInfo *
   createMachineFunctionInfo(BumpPtrAllocator &Allocator, const Function &F,
                             const TargetSubtargetInfo *STI) const override;
@@ -0,0 +1,269 @@
+//===-- Mwv208TargetTransformInfo.cpp - Mwv208 specific TTI -------*- C++
+//-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "Mwv208TargetTransformInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/CommandLine.h"
+
+using namespace llvm;
+
+#define DEBUG_TYPE "mwv208tti"
+
+static cl::opt<bool>
+    DisableHardwareLoops("mwv208-disable-hwloops", cl::Hidden,
+                         cl::init(false),
+                         cl::desc("Disable MWV208 LOOP/ENDLOOP generation"));
+
+static cl::opt<unsigned> PrivateArrayUnrollThreshold(
+    "mwv208-private-unroll-threshold", cl::Hidden, cl::init(800),
+    cl::desc("Unroll threshold for loops indexing a private array"));
+
+/// Cost of one lane of an operation without an instruction of its own,
+/// which is expanded around the scalar transcendental unit.
+static constexpr unsigned TransLaneCost = TargetTransformInfo::TCC_Expensive;
+
+bool Mwv208TTIImpl::shouldExpandReduction(const IntrinsicInst *II) const {
+  switch (II->getIntrinsicID()) {
+  case Intrinsic::vector_reduce_fadd:
+    // Without reassoc the reduction is sequential and cannot be a DP4.
+    return !(II->hasAllowReassoc() &&
+             II->getArgOperand(1)->getType() ==
+                 FixedVectorType::get(Type::getFloatTy(II->getContext()), 4));
+  default:
+    return true;
+  }
+}
+
+bool Mwv208TTIImpl::isSourceOfDivergence(const Value *V) const {
+  // Atomics hand every thread a different old value.
+  if (isa<AtomicRMWInst>(V) || isa<AtomicCmpXchgInst>(V))
+    return true;
+
+  // Builtins such as the thread index are external functions answered per
+  // thread. Target independent intrinsics are uniform on uniform operands.
+  if (const auto *CB = dyn_cast<CallBase>(V)) {
+    const Function *Callee = CB->getCalledFunction();
+    return !Callee || !Callee->isIntrinsic();
+  }
+
+  // Private arrays hold a copy per thread, whatever the index.
+  if (const auto *LI = dyn_cast<LoadInst>(V))
+    return isa<AllocaInst>(getUnderlyingObject(LI->getPointerOperand()));
+  return false;
+}
+
+bool Mwv208TTIImpl::isHardwareLoopProfitable(Loop *L, ScalarEvolution &SE,
+                                             AssumptionCache &AC,
+                                             TargetLibraryInfo *LibInfo,
+                                             HardwareLoopInfo &HWLoopInfo) {
+  if (DisableHardwareLoops)
+    return false;
+
+  // Only ENDLOOP pops the loop stack, a branch out of the body would leave
+  // the count behind.
+  if (!L->getExitingBlock())
+    return false;
+
+  // LOOP pushes a single count for the whole warp, read from src0.x, so the
+  // count must be the same in every thread. Kernel arguments and constants
+  // are; anything else, a builtin result or a private array load, may not
+  // be and stays a WHILE/ENDWHILE loop.
+  const SCEV *BTC = SE.getBackedgeTakenCount(L);
+  if (isa<SCEVCouldNotCompute>(BTC) ||
+      SCEVExprContains(BTC, [](const SCEV *S) {
+        const auto *U = dyn_cast<SCEVUnknown>(S);
+        return U && !isa<Argument>(U->getValue()) &&
+               !isa<Constant>(U->getValue());
+      }))
+    return false;
+
+  // HardwareLoops itself requires a computable trip count. LOOP loads it
+  // into the loop stack and ENDLOOP counts it down, so the counter never
+  // lives in a register and the body keeps no compare or branch of its own.
+  // The count comes from a 32-bit component, and only one loop of a nest is
+  // converted, which keeps the loop stack one deep.
+  LLVMContext &C = L->getHeader()->getContext();
+  HWLoopInfo.CounterInReg = false;
+  HWLoopInfo.IsNestingLegal = false;
+  HWLoopInfo.PerformEntryTest = false;
+  HWLoopInfo.CountType = Type::getInt32Ty(C);
+  HWLoopInfo.LoopDecrement = ConstantInt::get(HWLoopInfo.CountType, 1);
+  return true;
+}
+
+unsigned Mwv208TTIImpl::getNumberOfRegisters(unsigned ClassID) const {
+  // Class 1 holds vectors, class 0 scalars, which go four to a register.
+  bool Vector = ClassID == 1;
+  return Vector ? ST->getNumTempRegs() : ST->getNumTempRegs() * 4;
+}
+
+TypeSize
+Mwv208TTIImpl::getRegisterBitWidth(TargetTransformInfo::RegisterKind K) const {
+  switch (K) {
+  case TargetTransformInfo::RGK_Scalar:
+    return TypeSize::getFixed(32);
+  case TargetTransformInfo::RGK_FixedWidthVector:
+    return TypeSize::getFixed(128);
+  case TargetTransformInfo::RGK_ScalableVector:
+    return TypeSize::getScalable(0);
+  }
+  llvm_unreachable("Unsupported register kind");
+}
+
+static unsigned getNumLanes(Type *Ty) {
+  if (auto *VTy = dyn_cast<FixedVectorType>(Ty))
+    return VTy->getNumElements();
+  return 1;
+}
+
+InstructionCost Mwv208TTIImpl::getArithmeticInstrCost(
+    unsigned Opcode, Type *Ty, TTI::TargetCostKind CostKind,
+    TTI::OperandValueInfo Op1Info, TTI::OperandValueInfo Op2Info,
+    ArrayRef<const Value *> Args, const Instruction *CxtI) {
+  if (CostKind != TTI::TCK_RecipThroughput)
+    return BaseT::getArithmeticInstrCost(Opcode, Ty, CostKind, Op1Info,
+                                         Op2Info, Args, CxtI);
+
+  switch (Opcode) {
+  case Instruction::FDiv:
+  case Instruction::FRem:
+    // A reciprocal per lane and a mul.
+    return getNumLanes(Ty) * TransLaneCost + 1;
+  case Instruction::SDiv:
+  case Instruction::UDiv:
+  case Instruction::SRem:
+  case Instruction::URem:
+    // A float reciprocal, conversions and a correction step per lane.
+    return getNumLanes(Ty) * TransLaneCost * 4;
+  default:
+    return BaseT::getArithmeticInstrCost(Opcode, Ty, CostKind, Op1Info,
+                                         Op2Info, Args, CxtI);
+  }
+}
+
+InstructionCost
+Mwv208TTIImpl::getIntrinsicInstrCost(const IntrinsicCostAttributes &ICA,
+                                     TTI::TargetCostKind CostKind) {
+  unsigned Lanes = getNumLanes(ICA.getReturnType());
+  switch (ICA.getID()) {
+  case Intrinsic::sqrt:
+  case Intrinsic::exp:
+  case Intrinsic::exp2:
+  case Intrinsic::log:
+  case Intrinsic::log2:
+  case Intrinsic::log10:
+  case Intrinsic::sin:
+  case Intrinsic::cos:
+    return Lanes * TransLaneCost;
+  case Intrinsic::pow:
+    // exp2(y * log2(x)).
+    return Lanes * TransLaneCost * 2 + 1;
+  case Intrinsic::fma:
+  case Intrinsic::fmuladd:
+    // A single mad, whatever the width up to vec4.
+    return getTypeLegalizationCost(ICA.getReturnType()).first;
+  default:
+    return BaseT::getIntrinsicInstrCost(ICA, CostKind);
+  }
+}
+
+InstructionCost Mwv208TTIImpl::getShuffleCost(
+    TTI::ShuffleKind Kind, VectorType *Tp, ArrayRef<int> Mask,
+    TTI::TargetCostKind CostKind, int Index, VectorType *SubTp,
+    ArrayRef<const Value *> Args, const Instruction *CxtI) {
+  auto *FVTy = dyn_cast<FixedVectorType>(Tp);
+  if (!FVTy || FVTy->getNumElements() > 4 ||
+      FVTy->getScalarSizeInBits() != 32)
+    return BaseT::getShuffleCost(Kind, Tp, Mask, CostKind, Index, SubTp, Args,
+                                 CxtI);
+
+  switch (Kind) {
+  case TTI::SK_Broadcast:
+  case TTI::SK_Reverse:
+  case TTI::SK_PermuteSingleSrc:
+  case TTI::SK_ExtractSubvector:
+    // A swizzle of the source operand reading the vector.
+    return 0;
+  default:
+    // Two vectors: one sel between a swizzle of each, picked by a constant
+    // lane mask, see Mwv208TargetLowering::LowerOperation.
+    return 1;
+  }
+}
+
+InstructionCost Mwv208TTIImpl::getVectorInstrCost(unsigned Opcode, Type *Val,
+                                                  TTI::TargetCostKind CostKind,
+                                                  unsigned Index, Value *Op0,
+                                                  Value *Op1) {
+  // A constant lane is read through a swizzle and written through the
+  // write mask. A variable one needs a lane mask and a sel.
+  if (Index != -1U && getNumLanes(Val) <= 4)
+    return Opcode == Instruction::ExtractElement ? 0 : 1;
+  return BaseT::getVectorInstrCost(Opcode, Val, CostKind, Index, Op0, Op1);
+}
+
+InstructionCost Mwv208TTIImpl::getMemoryOpCost(unsigned Opcode, Type *Src,
+                                               MaybeAlign Alignment,
+                                               unsigned AddressSpace,
+                                               TTI::TargetCostKind CostKind,
+                                               TTI::OperandValueInfo OpInfo,
+                                               const Instruction *I) {
+  // Private and uniform arrays are registers, see Mwv208TargetLowering::
+  // LowerLOAD: an access is one mov per register whatever the width and
+  // alignment, plus a mova when the index is not a constant.
+  InstructionCost Cost = getTypeLegalizationCost(Src).first;
+  if (I) {
+    const Value *Ptr = getLoadStorePointerOperand(I);
+    if (const auto *GEP = dyn_cast_or_null<GetElementPtrInst>(Ptr))
+      if (!GEP->hasAllConstantIndices())
+        Cost += 1;
+  }
+  return Cost;
+}
+
+/// Whether \p L computes the index of a private array access from values
+/// that change between iterations.
+static bool indexesPrivateArray(const Loop *L) {
+  for (const BasicBlock *BB : L->blocks())
+    for (const Instruction &I : *BB) {
+      const auto *GEP = dyn_cast_or_null<GetElementPtrInst>(
+          getLoadStorePointerOperand(&I));
+      if (!GEP ||
+          !isa<AllocaInst>(GEP->getPointerOperand()->stripPointerCasts()))
+        continue;
+      if (any_of(GEP->indices(), [&](const Use &Idx) {
+            return !L->isLoopInvariant(Idx.get());
+          }))
+        return true;
+    }
+  return false;
+}
+
+void Mwv208TTIImpl::getUnrollingPreferences(Loop *L, ScalarEvolution &SE,
+                                            TTI::UnrollingPreferences &UP,
+                                            OptimizationRemarkEmitter *ORE) {
+  BaseT::getUnrollingPreferences(L, SE, UP, ORE);
+  // Kernels are small and there is no instruction cache miss to fear, but
+  // every remainder loop is another branch that may diverge, and counted
+  // loops are already free through LOOP/ENDLOOP. Unroll fully or partially
+  // by a known count only.
+  UP.Threshold = 300;
+  UP.PartialThreshold = 150;
+  UP.Partial = true;
+  UP.Runtime = false;
+  UP.MaxCount = 8;
+  if (indexesPrivateArray(L)) {
+    UP.Threshold = PrivateArrayUnrollThreshold;
+    UP.MaxPercentThresholdBoost = 400;
+  }
+}
@@ -0,0 +1,102 @@
+//===-- Mwv208TargetTransformInfo.h - Mwv208 specific TTI ---------*- C++
+//-*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file describes the Mwv208 specific TargetTransformInfo implementation,
+// the target hooks queried by the IR level optimizers.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_MWV208_MWV208TARGETTRANSFORMINFO_H
+#define LLVM_LIB_TARGET_MWV208_MWV208TARGETTRANSFORMINFO_H
+
+#include "Mwv208TargetMachine.h"
+#include "llvm/Analysis/TargetTransformInfo.h"
+#include "llvm/CodeGen/BasicTTIImpl.h"
+
+namespace llvm {
+
+class Mwv208TTIImpl : public BasicTTIImplBase<Mwv208TTIImpl> {
+  using BaseT = BasicTTIImplBase<Mwv208TTIImpl>;
+  using TTI = TargetTransformInfo;
+  friend BaseT;
+
+  const Mwv208Subtarget *ST;
+  const Mwv208TargetLowering *TLI;
+
+  const Mwv208Subtarget *getST() const { return ST; }
+  const Mwv208TargetLowering *getTLI() const { return TLI; }
+
+public:
+  explicit Mwv208TTIImpl(const Mwv208TargetMachine *TM, const Function &F)
+      : BaseT(TM, F.getDataLayout()), ST(TM->getSubtargetImpl(F)),
+        TLI(ST->getTargetLowering()) {}
+
+  /// Every lane of a warp runs its own thread, see Mwv208StructuredCF.
+  bool hasBranchDivergence(const Function *F = nullptr) const { return true; }
+
+  /// Kernel arguments live in the constant bank and are the same for every
+  /// thread. Values only start to differ between threads where they come
+  /// from a per-thread builtin or an atomic.
+  bool isSourceOfDivergence(const Value *V) const;
+
+  /// Reassociable fadd reductions of a vec4 product are a single DP4, keep
+  /// them as intrinsics so that instruction selection sees them.
+  bool shouldExpandReduction(const IntrinsicInst *II) const;
+
+  /// Counted loops become LOOP/ENDLOOP, see Mwv208HardwareLoops.
+  bool isHardwareLoopProfitable(Loop *L, ScalarEvolution &SE,
+                                AssumptionCache &AC,
+                                TargetLibraryInfo *LibInfo,
+                                HardwareLoopInfo &HWLoopInfo);
+
+  /// \name Vectorization
+  /// Every temp register holds a vec4 of 32-bit components, and scalars are
+  /// allocated to single components, see Mwv208TargetLowering.
+  /// @{
+  unsigned getNumberOfRegisters(unsigned ClassID) const;
+  TypeSize getRegisterBitWidth(TargetTransformInfo::RegisterKind K) const;
+  unsigned getMinVectorRegisterBitWidth() const { return 128; }
+  /// Interleaving only lengthens live ranges on a single issue core.
+  unsigned getMaxInterleaveFactor(ElementCount VF) const { return 1; }
+
+  InstructionCost getArithmeticInstrCost(
+      unsigned Opcode, Type *Ty, TTI::TargetCostKind CostKind,
+      TTI::OperandValueInfo Op1Info = {TTI::OK_AnyValue, TTI::OP_None},
+      TTI::OperandValueInfo Op2Info = {TTI::OK_AnyValue, TTI::OP_None},
+      ArrayRef<const Value *> Args = {}, const Instruction *CxtI = nullptr);
+  InstructionCost getIntrinsicInstrCost(const IntrinsicCostAttributes &ICA,
+                                        TTI::TargetCostKind CostKind);
+  InstructionCost getShuffleCost(TTI::ShuffleKind Kind, VectorType *Tp,
+                                 ArrayRef<int> Mask,
+                                 TTI::TargetCostKind CostKind, int Index,
+                                 VectorType *SubTp,
+                                 ArrayRef<const Value *> Args = {},
+                                 const Instruction *CxtI = nullptr);
+  using BaseT::getVectorInstrCost;
+  InstructionCost getVectorInstrCost(unsigned Opcode, Type *Val,
+                                     TTI::TargetCostKind CostKind,
+                                     unsigned Index, Value *Op0, Value *Op1);
+  InstructionCost getMemoryOpCost(
+      unsigned Opcode, Type *Src, MaybeAlign Alignment, unsigned AddressSpace,
+      TTI::TargetCostKind CostKind,
+      TTI::OperandValueInfo OpInfo = {TTI::OK_AnyValue, TTI::OP_None},
+      const Instruction *I = nullptr);
+  /// @}
+
+  /// Loops indexing a private array are unrolled more eagerly: once the
+  /// index is a constant the access is a plain register operand instead of
+  /// a mova and a relative mov.
+  void getUnrollingPreferences(Loop *L, ScalarEvolution &SE,
+                               TTI::UnrollingPreferences &UP,
+                               OptimizationRemarkEmitter *ORE);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_LIB_TARGET_MWV208_MWV208TARGETTRANSFORMINFO_H